@@ -0,0 +1,227 @@
+#include "AnimationPlayer.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace rgb_matrix;
+
+// Falling further behind than this restarts the timing instead of racing
+// through the missed frames
+#define ANIMATION_MAX_LAG_US 500000
+
+AnimationPlayer::AnimationPlayer()
+{
+    pack = NULL;
+    size = 0;
+    header = NULL;
+    index = NULL;
+    current = 0;
+    isPaused = false;
+    InvalidateCanvas();
+
+    // Prevent a button getting immediately handled
+    for (int i = 0; i < TOTAL_INPUTS; i++)
+    {
+        prevInputs[i] = true;
+    }
+}
+
+AnimationPlayer::~AnimationPlayer()
+{
+    closePack();
+}
+
+void AnimationPlayer::closePack()
+{
+    if (pack != NULL)
+    {
+        munmap((void *)pack, size);
+    }
+    pack = NULL;
+    size = 0;
+    header = NULL;
+    index = NULL;
+}
+
+// The header and index are checked here, payloads as they are decoded.
+// Packs smaller than the display are centered on it.
+bool AnimationPlayer::Open(const char *path, int width, int height)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        perror("open()");
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(AnimationPackHeader))
+    {
+        fprintf(stderr, "Animation pack '%s' is too short\n", path);
+        close(fd);
+        return false;
+    }
+    void *memory = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED)
+    {
+        perror("mmap()");
+        return false;
+    }
+
+    const AnimationPackHeader *h = (const AnimationPackHeader *)memory;
+    // 64 bit sums, size_t wraps on the Pi
+    uint64_t indexEnd = h->indexOffset + sizeof(AnimationPackEntry) * (uint64_t)h->frameCount;
+    if (h->magic != ANIMATION_PACK_MAGIC || h->version != ANIMATION_PACK_VERSION || h->frameCount == 0 ||
+        h->indexOffset % sizeof(uint64_t) != 0 || h->indexOffset > (uint64_t)st.st_size || indexEnd > (uint64_t)st.st_size)
+    {
+        fprintf(stderr, "'%s' is not an animation pack\n", path);
+        munmap(memory, st.st_size);
+        return false;
+    }
+    if (h->width == 0 || h->height == 0 || h->width > (uint32_t)width || h->height > (uint32_t)height)
+    {
+        fprintf(stderr, "Animation pack '%s' is %ux%u, the display is %dx%d\n", path, h->width, h->height, width, height);
+        munmap(memory, st.st_size);
+        return false;
+    }
+    const AnimationPackEntry *entries = (const AnimationPackEntry *)((const uint8_t *)memory + h->indexOffset);
+    for (uint32_t i = 0; i < h->frameCount; i++)
+    {
+        const AnimationPackEntry &e = entries[i];
+        bool isKnown = e.type == KeyRecord || (e.type == DeltaRecord && i > 0);
+        if (!isKnown || e.offset + e.length > (uint64_t)st.st_size)
+        {
+            fprintf(stderr, "Animation pack '%s' has a bad frame %u\n", path, i);
+            munmap(memory, st.st_size);
+            return false;
+        }
+    }
+
+    // Pages are read as playback reaches them
+    madvise(memory, st.st_size, MADV_SEQUENTIAL);
+
+    closePack();
+    pack = (const uint8_t *)memory;
+    size = st.st_size;
+    header = h;
+    index = (const AnimationPackEntry *)(pack + h->indexOffset);
+    current = 0;
+    InvalidateCanvas();
+    return true;
+}
+
+// Something else drew on the frame, next loop redraws the current frame
+void AnimationPlayer::InvalidateCanvas()
+{
+    isDrawn = false;
+}
+
+bool AnimationPlayer::decode(FrameBuffer *frame, int entry)
+{
+    const AnimationPackEntry &e = index[entry];
+    if (e.offset + e.length > size)
+    {
+        return false;
+    }
+    int x = (frame->width() - (int)header->width) / 2;
+    int y = (frame->height() - (int)header->height) / 2;
+    return DecodeFrame((FrameRecordType)e.type, pack + e.offset, e.length, header->width, header->height, frame, x, y);
+}
+
+// Deltas need the frame before them, rebuild from the last keyframe
+bool AnimationPlayer::redraw(FrameBuffer *frame)
+{
+    int key = current;
+    while (key > 0 && index[key].type != KeyRecord)
+    {
+        key--;
+    }
+
+    frame->Clear();
+    for (int i = key; i <= current; i++)
+    {
+        if (!decode(frame, i))
+        {
+            return false;
+        }
+    }
+    isDrawn = true;
+    nextFrame = Clock::now() + std::chrono::microseconds(index[current].durationUs);
+    return true;
+}
+
+// A corrupt frame ends playback. The pack is closed and the frame cleared
+// rather than showing what was decoded of it.
+int AnimationPlayer::stopCorrupt(FrameBuffer *frame)
+{
+    fprintf(stderr, "Animation frame %d is corrupt, playback stopped\n", current);
+    closePack();
+    frame->Clear();
+    frame->MarkDirty();
+    return -1;
+}
+
+int AnimationPlayer::Loop(FrameBuffer *frame, volatile bool *inputs)
+{
+    // Proccess inputs on button down
+    if (inputs[AButton] && !prevInputs[AButton])
+    {
+        isPaused = !isPaused;
+        nextFrame = Clock::now() + std::chrono::microseconds(index != NULL ? index[current].durationUs : 0);
+    }
+
+    if ((inputs[MenuButton] && !prevInputs[MenuButton]) || pack == NULL)
+    {
+        for (int i = 0; i < TOTAL_INPUTS; i++)
+        {
+            prevInputs[i] = inputs[i];
+            inputs[i] = false;
+        }
+
+        return -1;
+    }
+
+    for (int i = 0; i < TOTAL_INPUTS; i++)
+    {
+        prevInputs[i] = inputs[i];
+        inputs[i] = false;
+    }
+
+    if (!isDrawn)
+    {
+        if (!redraw(frame))
+        {
+            return stopCorrupt(frame);
+        }
+        frame->MarkDirty();
+        return 0;
+    }
+
+    Clock::time_point now = Clock::now();
+    if (isPaused || now < nextFrame)
+    {
+        return 0;
+    }
+
+    if (now - nextFrame > std::chrono::microseconds(ANIMATION_MAX_LAG_US))
+    {
+        nextFrame = now;
+    }
+
+    // Decode every frame that is due, only the last one is shown
+    while (nextFrame <= now)
+    {
+        current = (current + 1) % header->frameCount;
+        if (!decode(frame, current))
+        {
+            return stopCorrupt(frame);
+        }
+        nextFrame += std::chrono::microseconds(index[current].durationUs > 0 ? index[current].durationUs : 1);
+    }
+    frame->MarkDirty();
+
+    return 0;
+}
@@ -0,0 +1,76 @@
+#ifndef _animationplayer
+#define _animationplayer
+
+#include "Inputs.h"
+#include "FrameBuffer.h"
+#include "FrameCodec.h"
+
+#include <chrono>
+#include <stddef.h>
+#include <stdint.h>
+
+#define ANIMATION_PACK_MAGIC 0x50414D47
+#define ANIMATION_PACK_VERSION 1
+
+using namespace rgb_matrix;
+
+// Animation pack, every number little endian:
+// header, the frame payloads FrameRecorder writes, then the index with one
+// entry per frame at indexOffset. The first frame is a keyframe.
+struct AnimationPackHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    uint32_t frameCount;
+    uint32_t reserved;
+    uint64_t indexOffset;
+};
+
+struct AnimationPackEntry
+{
+    uint64_t offset;
+    uint32_t length;
+    uint32_t durationUs;
+    uint8_t type;
+    uint8_t reserved[7];
+};
+
+// Plays an animation pack, looping, centered on the frame.
+// The pack is mapped rather than read, so opening costs nothing however
+// big it is, and frames are decoded straight from the mapping into the
+// frame. Frames are shown for their duration, passes in between do no
+// work at all.
+class AnimationPlayer
+{
+    private:
+        typedef std::chrono::steady_clock Clock;
+
+        const uint8_t *pack;
+        size_t size;
+        const AnimationPackHeader *header;
+        const AnimationPackEntry *index;
+
+        int current;
+        bool isDrawn;
+        bool isPaused;
+        Clock::time_point nextFrame;
+        bool prevInputs[TOTAL_INPUTS];
+
+        void closePack();
+        bool decode(FrameBuffer *frame, int entry);
+        bool redraw(FrameBuffer *frame);
+        int stopCorrupt(FrameBuffer *frame);
+    public:
+        AnimationPlayer();
+        ~AnimationPlayer();
+
+        bool Open(const char *path, int width, int height);
+        inline bool IsOpen() const { return pack != NULL; }
+
+        void InvalidateCanvas();
+        int Loop(FrameBuffer *frame, volatile bool *inputs);
+};
+
+#endif
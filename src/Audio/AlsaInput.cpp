@@ -1,10 +1,11 @@
 #include "AlsaInput.h"
 
 #include <cinttypes>
+#include <cmath>
 #include <iostream>
 #include <stdlib.h>
 
-AlsaInput::AlsaInput(volatile bool isStopped , std::shared_ptr<ThreadSync> ts)
+AlsaInput::AlsaInput(volatile bool& isStopped, std::shared_ptr<ThreadSync> ts)
     : AudioInput(isStopped, ts)
 {
     const char* audio_source = "hw:CARD=Device,DEV=0";
@@ -13,7 +14,8 @@ AlsaInput::AlsaInput(volatile bool isStopped , std::shared_ptr<ThreadSync> ts)
     int err = snd_pcm_open(&handle, audio_source, SND_PCM_STREAM_CAPTURE, 0);
     if (err < 0) {
         std::cerr << "error opening stream: " << snd_strerror(err) << std::endl;
-        exit(EXIT_FAILURE);
+        handle = NULL;
+        return;
     }
 
     snd_pcm_hw_params_t* params;
@@ -42,15 +44,15 @@ AlsaInput::AlsaInput(volatile bool isStopped , std::shared_ptr<ThreadSync> ts)
     // Try setting the desired parameters
     err = snd_pcm_hw_params(handle, params);
     if (err < 0) {
-        std::cerr << "Unable to set audio parameters: " << snd_strerror(err) << std::endl;
-        exit(EXIT_FAILURE);
+        fail("Unable to set audio parameters: ", err);
+        return;
     }
 
     // Prepare the audio interface
     err = snd_pcm_prepare(handle);
     if (err < 0) {
-        std::cerr << "Cannot prepare audio interface for use: " << snd_strerror(err) << std::endl;
-        exit(EXIT_FAILURE);
+        fail("Cannot prepare audio interface for use: ", err);
+        return;
     }
 
     // Getting the actual format
@@ -82,12 +84,24 @@ AlsaInput::AlsaInput(volatile bool isStopped , std::shared_ptr<ThreadSync> ts)
 
     // Hope it's successful
     if (format == -1 || rate == 0) {
-        std::cerr << "Could not get rate and/or format, quiting..." << std::endl;
-        exit(EXIT_FAILURE);
+        fail("Could not get rate and/or format", 0);
     }
 }
 
-AlsaInput::~AlsaInput() { snd_pcm_close(handle); }
+AlsaInput::~AlsaInput()
+{
+    if (handle != NULL) {
+        snd_pcm_close(handle);
+    }
+}
+
+// Close the device, the input stays unopened
+void AlsaInput::fail(const char* what, int err)
+{
+    std::cerr << what << (err < 0 ? snd_strerror(err) : "") << std::endl;
+    snd_pcm_close(handle);
+    handle = NULL;
+}
 
 void AlsaInput::input_audio()
 {
@@ -8,11 +8,15 @@
 // ALSA sound input implementation.
 class AlsaInput : public AudioInput {
 public:
-    AlsaInput(volatile bool isStopped, std::shared_ptr<ThreadSync> ts);
+    AlsaInput(volatile bool& isStopped, std::shared_ptr<ThreadSync> ts);
     ~AlsaInput();
 
+    // False when there is no capture device, the thread must not be started
+    bool is_open() { return handle != NULL; }
+
 private:
     void input_audio() override;
+    void fail(const char* what, int err);
 
     snd_pcm_t* handle; // ALSA sound device handle
 };
@@ -9,7 +9,7 @@
 // : global(state)
 // , sync(ts)
 // , samples(new CircularBuffer<Sample>(524288))
-AudioInput::AudioInput(volatile bool isStopped, std::shared_ptr<ThreadSync> ts)
+AudioInput::AudioInput(volatile bool& isStopped, std::shared_ptr<ThreadSync> ts)
     : isStopped(isStopped)
     , sync(ts)
     , samples(new CircularBuffer<Sample>(524288))
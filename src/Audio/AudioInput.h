@@ -13,8 +13,8 @@
 class AudioInput {
 public:
     //AudioInput(GlobalState* state, std::shared_ptr<ThreadSync> ts);
-    AudioInput(volatile bool isStopped, std::shared_ptr<ThreadSync> ts);
-    ~AudioInput() = default;
+    AudioInput(volatile bool& isStopped, std::shared_ptr<ThreadSync> ts);
+    virtual ~AudioInput() = default;
 
     // Start audio input thread, use the global state to stop it
     void start_thread();
@@ -29,7 +29,7 @@ protected:
     virtual void input_audio() = 0;
 
     //GlobalState* global; // Global state for thread termination
-    volatile bool isStopped;
+    volatile bool& isStopped; // Set by the caller to end the input thread
     std::shared_ptr<ThreadSync> sync;
 
     std::thread thread; // Input thread
@@ -1,4 +1,4 @@
-#include "fft_data.h"
+#include "FFTData.h"
 
 #include <cstring>
 
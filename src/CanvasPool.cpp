@@ -0,0 +1,139 @@
+#include "CanvasPool.h"
+
+#include <stddef.h>
+
+using namespace rgb_matrix;
+
+CanvasPool::CanvasPool(RGBMatrix *matrix, int rotation)
+{
+    this->matrix = matrix;
+    // Odd turns only fit square displays, others round up to a half turn
+    this->rotation = ((rotation % 4) + 4) % 4;
+    if (matrix->width() != matrix->height() && this->rotation % 2 == 1)
+    {
+        this->rotation = (this->rotation + 1) % 4;
+    }
+    pendingTurns = 0;
+    backCanvas = matrix->CreateFrameCanvas();
+    buildSourceIndex();
+
+    for (int i = 0; i < CANVAS_POOL_SIZE; i++)
+    {
+        shadows[i].canvas = NULL;
+        shadows[i].pixels = NULL;
+    }
+    nextShadow = 0;
+}
+
+CanvasPool::~CanvasPool()
+{
+    // Canvases are owned and freed by the matrix
+    for (int i = 0; i < CANVAS_POOL_SIZE; i++)
+    {
+        delete shadows[i].pixels;
+    }
+}
+
+// Shadow of a canvas, a canvas seen for the first time needs a full upload
+FrameBuffer * CanvasPool::getShadow(FrameCanvas *canvas, bool *isNew)
+{
+    for (int i = 0; i < CANVAS_POOL_SIZE; i++)
+    {
+        if (shadows[i].canvas == canvas)
+        {
+            *isNew = false;
+            return shadows[i].pixels;
+        }
+    }
+
+    CanvasShadow *shadow = &shadows[nextShadow];
+    nextShadow = (nextShadow + 1) % CANVAS_POOL_SIZE;
+
+    if (shadow->pixels == NULL)
+    {
+        shadow->pixels = new FrameBuffer(canvas->width(), canvas->height());
+    }
+    shadow->canvas = canvas;
+    *isNew = true;
+    return shadow->pixels;
+}
+
+// Bake the rotation into one lookup per canvas pixel, so rotating costs
+// nothing while presenting. Frame and canvas have the same size, so odd
+// quarter turns are only possible on square displays.
+void CanvasPool::buildSourceIndex()
+{
+    int w = matrix->width();
+    int h = matrix->height();
+
+    sourceIndex.resize(w * h);
+    for (int y = 0; y < h; y++)
+    {
+        for (int x = 0; x < w; x++)
+        {
+            int srcX, srcY;
+            switch (rotation)
+            {
+                case 1:
+                    srcX = y;
+                    srcY = w - 1 - x;
+                    break;
+                case 2:
+                    srcX = w - 1 - x;
+                    srcY = h - 1 - y;
+                    break;
+                case 3:
+                    srcX = h - 1 - y;
+                    srcY = x;
+                    break;
+                default:
+                    srcX = x;
+                    srcY = y;
+                    break;
+            }
+            sourceIndex[y * w + x] = srcY * w + srcX;
+        }
+    }
+}
+
+// Turn the display a quarter clockwise, or half if it is not square, from
+// the next frame on
+void CanvasPool::Rotate()
+{
+    pendingTurns++;
+}
+
+// Upload the rotated frame into the back canvas in one pass, show it and
+// recycle the canvas it replaces. Only pixels that differ from what the
+// back canvas already holds go through SetPixel.
+void CanvasPool::Present(const FrameBuffer *frame, unsigned framerateFraction)
+{
+    int turns = pendingTurns.exchange(0);
+    if (turns > 0)
+    {
+        rotation = (rotation + turns * (matrix->width() == matrix->height() ? 1 : 2)) % 4;
+        buildSourceIndex();
+    }
+
+    bool isNew;
+    FrameBuffer *shadow = getShadow(backCanvas, &isNew);
+
+    const Pixel *pixels = frame->Data();
+    const int *source = &sourceIndex[0];
+    for (int y = 0; y < shadow->height(); y++)
+    {
+        Pixel *shadowRow = shadow->Row(y);
+        for (int x = 0; x < shadow->width(); x++)
+        {
+            const Pixel &p = pixels[*source++];
+            Pixel &s = shadowRow[x];
+            if (isNew || p.r != s.r || p.g != s.g || p.b != s.b)
+            {
+                backCanvas->SetPixel(x, y, p.r, p.g, p.b);
+                s = p;
+            }
+        }
+    }
+
+    backCanvas = matrix->SwapOnVSync(backCanvas, framerateFraction);
+}
@@ -0,0 +1,52 @@
+#ifndef _canvaspool
+#define _canvaspool
+
+#include "FrameBuffer.h"
+
+#include "led-matrix.h"
+
+#include <atomic>
+#include <vector>
+
+// Canvases swapped between, ours and the one the matrix starts with
+#define CANVAS_POOL_SIZE 2
+
+using namespace rgb_matrix;
+
+// Double buffered canvases reused for every frame.
+// SwapOnVSync hands back the canvas that was on screen, which becomes the
+// next one to draw into, so no canvas is created after startup.
+class CanvasPool
+{
+    private:
+        // Copy of what was last uploaded to a canvas
+        struct CanvasShadow
+        {
+            FrameCanvas *canvas;
+            FrameBuffer *pixels;
+        };
+        CanvasShadow shadows[CANVAS_POOL_SIZE];
+        int nextShadow;
+
+        RGBMatrix *matrix;
+        FrameCanvas *backCanvas;
+
+        // Quarter turns clockwise, and for every canvas pixel in row order
+        // the frame pixel it shows
+        int rotation;
+        std::vector<int> sourceIndex;
+        // Turns asked for since the last frame, Rotate may be called from
+        // another thread than the one presenting
+        std::atomic<int> pendingTurns;
+
+        FrameBuffer * getShadow(FrameCanvas *canvas, bool *isNew);
+        void buildSourceIndex();
+    public:
+        CanvasPool(RGBMatrix *matrix, int rotation);
+        ~CanvasPool();
+
+        void Rotate();
+        void Present(const FrameBuffer *frame, unsigned framerateFraction);
+};
+
+#endif
@@ -0,0 +1,271 @@
+#include "ColorStage.h"
+
+#include <math.h>
+#include <stddef.h>
+
+using namespace rgb_matrix;
+
+// Neutral white, the panel's native white point
+#define NEUTRAL_KELVIN 6500
+// Bits the panel gets per channel
+#define OUTPUT_BITS 8
+
+// Ordered starting error, so pixels of the same color don't flip together
+static const uint8_t bayer4[4][4] =
+{
+    {  0,  8,  2, 10 },
+    { 12,  4, 14,  6 },
+    {  3, 11,  1,  9 },
+    { 15,  7, 13,  5 }
+};
+
+ColorStage::ColorStage(TileRenderer *tiles, int width, int height, float gamma, int channelMicroamps, int budgetMilliamps)
+{
+    this->tiles = tiles;
+    this->gamma = gamma;
+    this->channelMicroamps = channelMicroamps;
+    this->budgetMilliamps = budgetMilliamps;
+    brightness = 100;
+    colorTemperature = NEUTRAL_KELVIN;
+    lastMilliamps = 0;
+    ditherBits = 0;
+    output = new FrameBuffer(width, height);
+    precise.resize(width * height * 3);
+    carry.resize(width * height * 3);
+    tileTotals.resize(tiles->TileCount(width, height));
+    buildLut();
+}
+
+ColorStage::~ColorStage()
+{
+    delete output;
+}
+
+// Channel gains of a black body at the given temperature, normalized so
+// the brightest channel is 1. Approximation of the CIE black body colors.
+void ColorStage::whitePoint(int kelvin, float *gains)
+{
+    float t = kelvin / 100.0f;
+    float r, g, b;
+
+    if (t <= 66)
+    {
+        r = 255;
+        g = 99.4708025861f * logf(t) - 161.1195681661f;
+        b = t <= 19 ? 0 : 138.5177312231f * logf(t - 10) - 305.0447927307f;
+    }
+    else
+    {
+        r = 329.698727446f * powf(t - 60, -0.1332047592f);
+        g = 288.1221695283f * powf(t - 60, -0.0755148492f);
+        b = 255;
+    }
+
+    float rgb[3] = { r, g, b };
+    float max = 0;
+    for (int c = 0; c < 3; c++)
+    {
+        rgb[c] = rgb[c] < 0 ? 0 : (rgb[c] > 255 ? 255 : rgb[c]);
+        max = rgb[c] > max ? rgb[c] : max;
+    }
+    for (int c = 0; c < 3; c++)
+    {
+        gains[c] = rgb[c] / max;
+    }
+}
+
+// Bake brightness and white point into one table per channel, gamma too
+// when dithering. The gains are for duty, encoded values take their root.
+// The neutral temperature is left out so it maps white to white.
+void ColorStage::buildLut()
+{
+    float gains[3] = { 1, 1, 1 };
+    lutBrightness = brightness;
+    lutTemperature = colorTemperature;
+    if (lutTemperature != NEUTRAL_KELVIN)
+    {
+        float neutral[3];
+        whitePoint(NEUTRAL_KELVIN, neutral);
+        whitePoint(lutTemperature, gains);
+        for (int c = 0; c < 3; c++)
+        {
+            gains[c] = neutral[c] > 0 ? gains[c] / neutral[c] : 0;
+            gains[c] = gains[c] > 1 ? 1 : gains[c];
+        }
+    }
+
+    for (int c = 0; c < 3; c++)
+    {
+        float scale = COLOR_PRECISE_MAX * gains[c] * lutBrightness / 100.0f;
+        float encodedScale = COLOR_PRECISE_MAX * powf(gains[c] * lutBrightness / 100.0f, 1 / gamma);
+        for (int v = 0; v < 256; v++)
+        {
+            duty[c][v] = (uint16_t)lroundf(powf(v / 255.0f, gamma) * scale);
+            lut[c][v] = ditherBits > 0 ? duty[c][v] : (uint16_t)lroundf(v / 255.0f * encodedScale);
+        }
+    }
+}
+
+void ColorStage::SetBrightness(int percent)
+{
+    brightness = percent < 0 ? 0 : (percent > 100 ? 100 : percent);
+}
+
+void ColorStage::SetColorTemperature(int kelvin)
+{
+    colorTemperature = kelvin;
+}
+
+// Panel PWM bits to dither down to, 0 turns dithering off
+void ColorStage::SetDitherBits(int bits)
+{
+    bits = bits < 0 ? 0 : (bits > OUTPUT_BITS ? OUTPUT_BITS : bits);
+    if (bits != ditherBits)
+    {
+        ditherBits = bits;
+        seedCarry();
+        buildLut();
+    }
+}
+
+void ColorStage::seedCarry()
+{
+    if (ditherBits == 0)
+    {
+        return;
+    }
+
+    // Spread the starting error over one quantization step
+    int shift = COLOR_PRECISE_BITS - ditherBits;
+    int w = output->width();
+    for (int y = 0; y < output->height(); y++)
+    {
+        for (int x = 0; x < w; x++)
+        {
+            int16_t seed = (bayer4[y & 3][x & 3] << shift) >> 4;
+            for (int c = 0; c < 3; c++)
+            {
+                carry[(y * w + x) * 3 + c] = seed;
+            }
+        }
+    }
+}
+
+// Map a band of rows to table precision, returns its channel total
+uint32_t ColorStage::mapRows(const FrameBuffer *frame, int top, int bottom)
+{
+    int w = output->width();
+    const Pixel *in = frame->Data();
+    uint16_t *values = &precise[0];
+    int begin = top * w;
+    int end = bottom * w;
+
+    // Current grows linearly with duty, not with the encoded value
+    uint32_t total = 0;
+    for (int i = begin; i < end; i++)
+    {
+        values[i * 3] = lut[0][in[i].r];
+        values[i * 3 + 1] = lut[1][in[i].g];
+        values[i * 3 + 2] = lut[2][in[i].b];
+        total += duty[0][in[i].r] + duty[1][in[i].g] + duty[2][in[i].b];
+    }
+    return total;
+}
+
+// Scale a band of rows to the power budget and quantize it for the panel
+void ColorStage::quantizeRows(uint32_t scale, int top, int bottom)
+{
+    int w = output->width();
+    uint16_t *values = &precise[0];
+    uint8_t *out = (uint8_t *)output->Data();
+    int begin = top * w;
+    int end = bottom * w;
+
+    if (scale < 256)
+    {
+        for (int i = begin * 3; i < end * 3; i++)
+        {
+            values[i] = (values[i] * scale) >> 8;
+        }
+    }
+
+    if (ditherBits == 0)
+    {
+        // Round to the nearest output level, so encoded values map back to
+        // the levels they came from
+        int levelMax = (1 << OUTPUT_BITS) - 1;
+        for (int i = begin; i < end; i++)
+        {
+            for (int c = 0; c < 3; c++)
+            {
+                out[i * 4 + c] = (values[i * 3 + c] * levelMax + COLOR_PRECISE_MAX / 2) / COLOR_PRECISE_MAX;
+            }
+        }
+        return;
+    }
+
+    // Keep the top PWM bits, the library drops the ones below them
+    int shift = COLOR_PRECISE_BITS - ditherBits;
+    int levelMax = (1 << ditherBits) - 1;
+    int16_t *error = &carry[0];
+    for (int i = begin; i < end; i++)
+    {
+        for (int c = 0; c < 3; c++)
+        {
+            int v = values[i * 3 + c] + error[i * 3 + c];
+            int level = v >> shift;
+            int lost = v - (level << shift);
+            // The top step can't be reached, don't let its error pile up
+            if (level > levelMax)
+            {
+                level = levelMax;
+                lost = (1 << shift) - 1;
+            }
+            error[i * 3 + c] = lost;
+            out[i * 4 + c] = level << (OUTPUT_BITS - ditherBits);
+        }
+    }
+}
+
+// Returns the frame as it should go to the panel, in a buffer owned by the
+// stage. The mode's frame is left as it was drawn. Bands are mapped in
+// parallel, then scaled once the whole frame's current is known.
+const FrameBuffer * ColorStage::Apply(const FrameBuffer *frame)
+{
+    int w = output->width();
+    int h = output->height();
+
+    if (brightness != lutBrightness || colorTemperature != lutTemperature)
+    {
+        buildLut();
+    }
+
+    tiles->Run(w, h, [&](int top, int bottom, int tile) {
+        tileTotals[tile] = mapRows(frame, top, bottom);
+    });
+
+    uint32_t total = 0;
+    for (int i = 0; i < tiles->TileCount(w, h); i++)
+    {
+        total += tileTotals[i];
+    }
+
+    int64_t milliamps = (int64_t)total * channelMicroamps / (COLOR_PRECISE_MAX * 1000);
+    lastMilliamps = (int)milliamps;
+    uint32_t scale = 256;
+    if (budgetMilliamps > 0 && milliamps > budgetMilliamps)
+    {
+        scale = (uint32_t)(budgetMilliamps * 256 / milliamps);
+        // The scale is for duty, encoded values are scaled by its root
+        if (ditherBits == 0)
+        {
+            scale = (uint32_t)lroundf(powf(scale / 256.0f, 1 / gamma) * 256);
+        }
+    }
+
+    tiles->Run(w, h, [&](int top, int bottom, int tile) {
+        quantizeRows(scale, top, bottom);
+    });
+
+    return output;
+}
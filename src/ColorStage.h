@@ -0,0 +1,78 @@
+#ifndef _colorstage
+#define _colorstage
+
+#include "FrameBuffer.h"
+#include "TileRenderer.h"
+
+#include <atomic>
+#include <stdint.h>
+#include <vector>
+
+// Precision the color tables work in, finer than the panel can show
+#define COLOR_PRECISE_BITS 12
+#define COLOR_PRECISE_MAX ((1 << COLOR_PRECISE_BITS) - 1)
+
+using namespace rgb_matrix;
+
+// Last step before a frame is presented.
+// Maps every channel through a lookup baked from brightness and white
+// point, then estimates the panel current and scales the frame down when it
+// would draw more than the power budget. The output stays gamma encoded and
+// the library's luminance correction turns it into PWM duty, gamma is only
+// used to estimate that duty. 8 bits of duty would lose the darkest levels.
+// With dithering on the stage applies gamma itself and the library's
+// correction has to be off. The precise duty is quantized to the panel's PWM
+// bits and what is lost is carried into the next frame, so a pixel flips
+// between neighbouring levels and averages to the precise one.
+// Brightness and color temperature may be set from another thread than the
+// one applying, the tables are rebuilt by the next Apply.
+class ColorStage
+{
+    private:
+        float gamma;
+        std::atomic<int> brightness;
+        std::atomic<int> colorTemperature;
+
+        // What the tables were baked with
+        int lutBrightness;
+        int lutTemperature;
+        uint16_t lut[3][256];
+        // Estimated PWM duty of each input level, for the current
+        uint16_t duty[3][256];
+
+        // Channels in frame order at table precision, and the per channel
+        // error dithering carries to the next frame
+        std::vector<uint16_t> precise;
+        std::vector<int16_t> carry;
+        int ditherBits;
+
+        // Estimated current of one channel fully on, and what the whole
+        // display may draw
+        int channelMicroamps;
+        int budgetMilliamps;
+        int lastMilliamps;
+
+        FrameBuffer *output;
+        TileRenderer *tiles;
+        std::vector<uint32_t> tileTotals;
+
+        void buildLut();
+        static void whitePoint(int kelvin, float *gains);
+        void seedCarry();
+        uint32_t mapRows(const FrameBuffer *frame, int top, int bottom);
+        void quantizeRows(uint32_t scale, int top, int bottom);
+    public:
+        ColorStage(TileRenderer *tiles, int width, int height, float gamma, int channelMicroamps, int budgetMilliamps);
+        ~ColorStage();
+
+        void SetBrightness(int percent);
+        void SetColorTemperature(int kelvin);
+        void SetDitherBits(int bits);
+        inline bool IsDithering() const { return ditherBits > 0; }
+        inline int Brightness() const { return brightness; }
+        inline int EstimatedMilliamps() const { return lastMilliamps; }
+
+        const FrameBuffer * Apply(const FrameBuffer *frame);
+};
+
+#endif
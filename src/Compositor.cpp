@@ -0,0 +1,186 @@
+#include "Compositor.h"
+
+#include <string.h>
+
+using namespace rgb_matrix;
+
+Compositor::Compositor(TileRenderer *tiles, FrameExport *exporter, int width, int height)
+{
+    this->tiles = tiles;
+    this->exporter = exporter != NULL && exporter->IsOpen() ? exporter : NULL;
+    base = new FrameBuffer(width, height);
+    base->Fill(0, 0, 0);
+    for (int i = 0; i < COMPOSITOR_LAYERS; i++)
+    {
+        // Layers start out fully transparent
+        layers[i] = new FrameBuffer(width, height);
+        layers[i]->ClearDirty();
+        composites[i] = new FrameBuffer(width, height);
+        isVisible[i] = true;
+        blendModes[i] = OverBlend;
+        rowOffsets[i] = 0;
+        isStale[i] = true;
+    }
+    ownOutput = composites[COMPOSITOR_LAYERS - 1];
+}
+
+Compositor::~Compositor()
+{
+    for (int i = 0; i < COMPOSITOR_LAYERS; i++)
+    {
+        delete layers[i];
+    }
+    for (int i = 0; i < COMPOSITOR_LAYERS - 1; i++)
+    {
+        delete composites[i];
+    }
+    delete ownOutput;
+    delete base;
+}
+
+void Compositor::SetVisible(int index, bool isVisible)
+{
+    if (this->isVisible[index] != isVisible)
+    {
+        this->isVisible[index] = isVisible;
+        isStale[index] = true;
+    }
+}
+
+void Compositor::SetBlend(int index, int mode)
+{
+    if (blendModes[index] != mode)
+    {
+        blendModes[index] = mode;
+        isStale[index] = true;
+    }
+}
+
+// Layer row shown at the top of the frame
+void Compositor::SetRowOffset(int index, int rows)
+{
+    if (rowOffsets[index] != rows)
+    {
+        rowOffsets[index] = rows;
+        isStale[index] = true;
+    }
+}
+
+// src over dst. Everything below is opaque, so the result is too.
+// Written as a plain loop over the channels so the compiler vectorizes it
+// on 16 bit lanes, div255 is x / 255 rounded for every product here.
+static inline uint16_t div255(uint16_t x)
+{
+    x += 128;
+    return (x + (x >> 8)) >> 8;
+}
+
+void Compositor::blend(const Pixel *s, const Pixel *d, Pixel *o, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        uint16_t a = s[i].a;
+        uint16_t ia = 255 - a;
+        o[i].r = div255(s[i].r * a + d[i].r * ia);
+        o[i].g = div255(s[i].g * a + d[i].g * ia);
+        o[i].b = div255(s[i].b * a + d[i].b * ia);
+        o[i].a = 255;
+    }
+}
+
+// src added to dst, saturating, so sparks only ever brighten
+void Compositor::add(const Pixel *s, const Pixel *d, Pixel *o, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        uint16_t r = s[i].r + d[i].r;
+        uint16_t g = s[i].g + d[i].g;
+        uint16_t b = s[i].b + d[i].b;
+        o[i].r = r > 255 ? 255 : r;
+        o[i].g = g > 255 ? 255 : g;
+        o[i].b = b > 255 ? 255 : b;
+        o[i].a = 255;
+    }
+}
+
+// Rows of a layer onto the composite below it. With a row offset the
+// layer's rows wrap around, so a band takes at most two spans of them.
+void Compositor::composeLayer(int index, int top, int bottom)
+{
+    const FrameBuffer *below = index == 0 ? base : composites[index - 1];
+    int w = below->width();
+    int h = below->height();
+    for (int y = top; y < bottom; )
+    {
+        int source = (y + rowOffsets[index]) % h;
+        int rows = bottom - y < h - source ? bottom - y : h - source;
+        if (blendModes[index] == AddBlend)
+        {
+            add(layers[index]->Row(source), below->Row(y), composites[index]->Row(y), w * rows);
+        }
+        else
+        {
+            blend(layers[index]->Row(source), below->Row(y), composites[index]->Row(y), w * rows);
+        }
+        y += rows;
+    }
+}
+
+void Compositor::composeRows(int first, int top, int bottom)
+{
+    for (int i = first; i < COMPOSITOR_LAYERS; i++)
+    {
+        const FrameBuffer *below = i == 0 ? base : composites[i - 1];
+        if (isVisible[i])
+        {
+            composeLayer(i, top, bottom);
+        }
+        else
+        {
+            int w = below->width();
+            memcpy(composites[i]->Row(top), below->Row(top), sizeof(Pixel) * w * (bottom - top));
+        }
+    }
+}
+
+// Re-blend from the lowest changed layer up, the layers below it keep
+// their cached composites
+void Compositor::Compose()
+{
+    int first = COMPOSITOR_LAYERS;
+    for (int i = 0; i < COMPOSITOR_LAYERS; i++)
+    {
+        if (isStale[i] || (isVisible[i] && layers[i]->IsDirty()))
+        {
+            first = i;
+            break;
+        }
+    }
+    if (first == COMPOSITOR_LAYERS)
+    {
+        return;
+    }
+
+    // The top composite is always blended in full, so it can go to a new
+    // export slot every time
+    if (exporter != NULL)
+    {
+        composites[COMPOSITOR_LAYERS - 1] = exporter->Acquire();
+    }
+
+    // Bands of rows don't depend on each other, each goes up every layer
+    tiles->Run(Output()->width(), Output()->height(), [&](int top, int bottom, int tile) {
+        composeRows(first, top, bottom);
+    });
+
+    for (int i = first; i < COMPOSITOR_LAYERS; i++)
+    {
+        layers[i]->ClearDirty();
+        isStale[i] = false;
+    }
+    if (exporter != NULL)
+    {
+        exporter->Publish();
+    }
+    Output()->MarkDirty();
+}
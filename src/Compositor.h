@@ -0,0 +1,66 @@
+#ifndef _compositor
+#define _compositor
+
+#include "FrameBuffer.h"
+#include "TileRenderer.h"
+#include "FrameExport.h"
+
+#define COMPOSITOR_LAYERS 3
+
+using namespace rgb_matrix;
+
+enum CompositorLayer
+{
+    BackgroundLayer,
+    GameLayer,
+    OverlayLayer
+};
+
+// How a layer goes onto the ones below it. Over uses the layer's alpha,
+// add treats its color as light and ignores alpha.
+enum CompositorBlend
+{
+    OverBlend,
+    AddBlend
+};
+
+// Stacks RGBA layers bottom to top over black.
+// Every layer keeps the composite of itself and everything below it, so a
+// change only re-blends the changed layer and the ones above it. Layers
+// mark themselves dirty when drawn into, like the frame they replace.
+// A layer can be read starting at a row offset, wrapping around, so a mode
+// scrolling through a ring of rows never has to move them.
+class Compositor
+{
+    private:
+        FrameBuffer *layers[COMPOSITOR_LAYERS];
+        FrameBuffer *composites[COMPOSITOR_LAYERS];
+        FrameBuffer *base;
+        bool isVisible[COMPOSITOR_LAYERS];
+        int blendModes[COMPOSITOR_LAYERS];
+        int rowOffsets[COMPOSITOR_LAYERS];
+        bool isStale[COMPOSITOR_LAYERS];
+        TileRenderer *tiles;
+        // Top composite is rendered into the export ring when there is one
+        FrameExport *exporter;
+        FrameBuffer *ownOutput;
+
+        static void blend(const Pixel *s, const Pixel *d, Pixel *o, int count);
+        static void add(const Pixel *s, const Pixel *d, Pixel *o, int count);
+        void composeLayer(int index, int top, int bottom);
+        void composeRows(int first, int top, int bottom);
+    public:
+        Compositor(TileRenderer *tiles, FrameExport *exporter, int width, int height);
+        ~Compositor();
+
+        inline FrameBuffer * Layer(int index) { return layers[index]; }
+        void SetVisible(int index, bool isVisible);
+        void SetBlend(int index, int mode);
+        void SetRowOffset(int index, int rows);
+
+        // Top composite, it is marked dirty whenever Compose changes it
+        inline FrameBuffer * Output() { return composites[COMPOSITOR_LAYERS - 1]; }
+        void Compose();
+};
+
+#endif
@@ -0,0 +1,48 @@
+// Host tool showing the frames a running GameMatrix exports, in a
+// truecolor terminal. Works next to the panels, nothing is taken from them.
+// Usage: ExportView [<shared memory name>]
+
+#include "FrameExport.h"
+#include "TerminalPreview.h"
+
+#include <signal.h>
+#include <stdio.h>
+#include <unistd.h>
+
+// How often the export is checked for a new frame
+#define POLL_US 5000
+
+static volatile bool interrupted = false;
+
+static void interruptHandler(int signo)
+{
+    interrupted = true;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *name = argc > 1 ? argv[1] : FRAME_EXPORT_NAME;
+    FrameExportReader reader(name);
+    if (!reader.IsOpen())
+    {
+        fprintf(stderr, "No frame export at '%s', is GameMatrix running?\n", name);
+        return 1;
+    }
+
+    signal(SIGTERM, interruptHandler);
+    signal(SIGINT, interruptHandler);
+
+    FrameBuffer frame(reader.Width(), reader.Height());
+    TerminalPreview *preview = new TerminalPreview(STDOUT_FILENO, reader.Width(), reader.Height());
+    while (!interrupted)
+    {
+        uint64_t number, timestampUs;
+        if (reader.Read(frame.Data(), &number, &timestampUs))
+        {
+            preview->Present(&frame);
+        }
+        usleep(POLL_US);
+    }
+    delete preview;
+    return 0;
+}
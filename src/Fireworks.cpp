@@ -0,0 +1,81 @@
+#include "Fireworks.h"
+
+#include <stdlib.h>
+
+using namespace rgb_matrix;
+
+// Bright shell colors
+static const Pixel shellColors[] =
+{
+    MakePixel(255, 60, 40),
+    MakePixel(255, 200, 40),
+    MakePixel(80, 255, 80),
+    MakePixel(60, 140, 255),
+    MakePixel(220, 80, 255),
+    MakePixel(255, 255, 255)
+};
+
+Fireworks::Fireworks(ParticleSystem *particles)
+{
+    this->particles = particles;
+
+    // Prevent a button getting immediately handled
+    for (int i = 0; i < TOTAL_INPUTS; i++)
+    {
+        prevInputs[i] = true;
+    }
+}
+
+// Start from an empty sky
+void Fireworks::InvalidateCanvas()
+{
+    particles->Clear();
+    particles->InvalidateCanvas();
+}
+
+// Burst somewhere in the upper two thirds, bigger shells spread faster
+void Fireworks::launch(FrameBuffer *frame, int particleCount)
+{
+    float x = frame->width() / 8 + rand() % (frame->width() * 3 / 4);
+    float y = frame->height() / 8 + rand() % (frame->height() / 2);
+    const Pixel &color = shellColors[rand() % (sizeof(shellColors) / sizeof(shellColors[0]))];
+    float speed = particleCount > FIREWORKS_SHELL_PARTICLES ? 1.6f : 0.9f;
+    particles->Burst(x, y, particleCount, speed, color, 60 + rand() % 30);
+}
+
+int Fireworks::Loop(FrameBuffer *frame, volatile bool *inputs)
+{
+    // Proccess inputs on button down
+    if (inputs[AButton] && !prevInputs[AButton])
+    {
+        launch(frame, FIREWORKS_FINALE_PARTICLES);
+    }
+
+    if (inputs[MenuButton] && !prevInputs[MenuButton])
+    {
+        for (int i = 0; i < TOTAL_INPUTS; i++)
+        {
+            prevInputs[i] = inputs[i];
+            inputs[i] = false;
+        }
+
+        particles->Clear();
+        return -1;
+    }
+
+    for (int i = 0; i < TOTAL_INPUTS; i++)
+    {
+        prevInputs[i] = inputs[i];
+        inputs[i] = false;
+    }
+
+    if (rand() % FIREWORKS_LAUNCH_FRAMES == 0)
+    {
+        launch(frame, FIREWORKS_SHELL_PARTICLES);
+    }
+
+    particles->Update();
+    particles->Draw(frame);
+
+    return 0;
+}
@@ -0,0 +1,30 @@
+#ifndef _fireworks
+#define _fireworks
+
+#include "Inputs.h"
+#include "FrameBuffer.h"
+#include "Particles.h"
+
+using namespace rgb_matrix;
+
+// Shells launched in one of this many frames on average
+#define FIREWORKS_LAUNCH_FRAMES 20
+#define FIREWORKS_SHELL_PARTICLES 400
+#define FIREWORKS_FINALE_PARTICLES 4000
+
+// Fireworks bursting at random over the frame, A fires a big one
+class Fireworks
+{
+    private:
+        ParticleSystem *particles;
+        bool prevInputs[TOTAL_INPUTS];
+
+        void launch(FrameBuffer *frame, int particleCount);
+    public:
+        Fireworks(ParticleSystem *particles);
+
+        void InvalidateCanvas();
+        int Loop(FrameBuffer *frame, volatile bool *inputs);
+};
+
+#endif
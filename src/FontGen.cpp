@@ -0,0 +1,154 @@
+// Build time tool turning BDF fonts into glyph bitmap tables.
+// Usage: FontGen <name> <font.bdf> [<name> <font.bdf> ...] > Fonts.h
+
+#include "GlyphFont.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+// Replacement glyph the library falls back to for missing characters
+#define REPLACEMENT_CODEPOINT 0xFFFD
+
+struct BdfGlyph
+{
+    bool isFound;
+    int width;
+    int height;
+    int yOffset;
+    std::vector<uint32_t> rows;
+};
+
+static bool parseBdf(const char *path, int *height, int *baseline, BdfGlyph *glyphs, BdfGlyph *replacement)
+{
+    FILE *f = fopen(path, "r");
+    if (f == NULL)
+    {
+        fprintf(stderr, "Couldn't open font '%s'\n", path);
+        return false;
+    }
+
+    char buffer[1024];
+    int dummy;
+    long codepoint = -1;
+    int row = -1;
+    BdfGlyph current;
+    BdfGlyph *target = NULL;
+
+    while (fgets(buffer, sizeof(buffer), f))
+    {
+        int yOffset;
+        unsigned int bits;
+        if (sscanf(buffer, "FONTBOUNDINGBOX %d %d %d %d", &dummy, height, &dummy, &yOffset) == 4)
+        {
+            *baseline = *height + yOffset;
+        }
+        else if (sscanf(buffer, "ENCODING %ld", &codepoint) == 1)
+        {
+            current = BdfGlyph();
+            target = NULL;
+            if (codepoint >= GLYPH_FIRST && codepoint <= GLYPH_LAST)
+            {
+                target = &glyphs[codepoint - GLYPH_FIRST];
+            }
+            else if (codepoint == REPLACEMENT_CODEPOINT)
+            {
+                target = replacement;
+            }
+        }
+        else if (sscanf(buffer, "DWIDTH %d %d", &current.width, &dummy) == 2)
+        {
+        }
+        else if (sscanf(buffer, "BBX %d %d %d %d", &dummy, &current.height, &dummy, &current.yOffset) == 4)
+        {
+            row = -1;
+        }
+        else if (strncmp(buffer, "BITMAP", strlen("BITMAP")) == 0)
+        {
+            row = 0;
+        }
+        else if (strncmp(buffer, "ENDCHAR", strlen("ENDCHAR")) == 0)
+        {
+            if (target != NULL)
+            {
+                current.isFound = true;
+                *target = current;
+            }
+            target = NULL;
+            row = -1;
+        }
+        else if (target != NULL && row >= 0 && row < current.height && sscanf(buffer, "%x", &bits) == 1)
+        {
+            // Hex rows are padded to whole bytes, left align them
+            int digits = strspn(buffer, "0123456789abcdefABCDEF");
+            current.rows.push_back(bits << (32 - 4 * digits));
+            row++;
+        }
+    }
+
+    fclose(f);
+    return true;
+}
+
+static void printFont(const char *name, const char *path, int height, int baseline, BdfGlyph *glyphs, BdfGlyph *replacement)
+{
+    std::vector<uint32_t> rows;
+    printf("// %s\n", path);
+    printf("constexpr Glyph %sGlyphs[GLYPH_COUNT] =\n{\n", name);
+    for (int i = 0; i < GLYPH_COUNT; i++)
+    {
+        BdfGlyph *g = glyphs[i].isFound ? &glyphs[i] : replacement;
+        if (!g->isFound)
+        {
+            printf("    { 0, 0, 0, 0 },\n");
+            continue;
+        }
+        printf("    { %d, %d, %d, %d }, // '%c'\n", g->width, (int)g->rows.size(), g->yOffset, (int)rows.size(), GLYPH_FIRST + i);
+        rows.insert(rows.end(), g->rows.begin(), g->rows.end());
+    }
+    printf("};\n\n");
+
+    printf("constexpr uint32_t %sRows[] =\n{", name);
+    for (size_t i = 0; i < rows.size(); i++)
+    {
+        printf("%s0x%08x,", i % 8 == 0 ? "\n    " : " ", rows[i]);
+    }
+    printf("\n};\n\n");
+
+    printf("constexpr GlyphFont %s = { %d, %d, %sGlyphs, %sRows };\n\n", name, height, baseline, name, name);
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 3 || argc % 2 == 0)
+    {
+        fprintf(stderr, "Usage: %s <name> <font.bdf> [<name> <font.bdf> ...]\n", argv[0]);
+        return 1;
+    }
+
+    printf("// Generated by FontGen, do not edit\n\n");
+    printf("#ifndef _fonts\n#define _fonts\n\n#include \"GlyphFont.h\"\n\n");
+
+    for (int i = 1; i < argc; i += 2)
+    {
+        int height = 0;
+        int baseline = 0;
+        BdfGlyph glyphs[GLYPH_COUNT];
+        BdfGlyph replacement;
+        for (int g = 0; g < GLYPH_COUNT; g++)
+        {
+            glyphs[g].isFound = false;
+        }
+        replacement.isFound = false;
+
+        if (!parseBdf(argv[i + 1], &height, &baseline, glyphs, &replacement))
+        {
+            return 1;
+        }
+        printFont(argv[i], argv[i + 1], height, baseline, glyphs, &replacement);
+    }
+
+    printf("#endif\n");
+    return 0;
+}
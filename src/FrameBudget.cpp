@@ -0,0 +1,57 @@
+#include "FrameBudget.h"
+
+FrameBudget::FrameBudget(int budgetMicros, int raisePercent)
+{
+    this->budgetMicros = budgetMicros;
+    this->raisePercent = raisePercent;
+    level = QUALITY_LEVELS - 1;
+    historyCount = 0;
+    historyNext = 0;
+    frameStart = Clock::now();
+}
+
+void FrameBudget::Begin()
+{
+    frameStart = Clock::now();
+}
+
+// Record the frame since Begin, returns true when the level changed
+bool FrameBudget::End()
+{
+    int elapsed = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - frameStart).count();
+    history[historyNext] = elapsed;
+    historyNext = (historyNext + 1) % FRAME_BUDGET_HISTORY;
+    if (historyCount < FRAME_BUDGET_HISTORY)
+    {
+        historyCount++;
+    }
+
+    int64_t total = 0;
+    for (int i = 0; i < historyCount; i++)
+    {
+        total += history[i];
+    }
+    int average = total / historyCount;
+
+    // Falling behind is acted on as soon as half the history shows it,
+    // raising quality waits for a full history
+    int newLevel = level;
+    if (average > budgetMicros && historyCount >= FRAME_BUDGET_HISTORY / 2 && level > 0)
+    {
+        newLevel--;
+    }
+    else if (average * 100 < budgetMicros * raisePercent && historyCount == FRAME_BUDGET_HISTORY && level < QUALITY_LEVELS - 1)
+    {
+        newLevel++;
+    }
+
+    if (newLevel == level)
+    {
+        return false;
+    }
+
+    level = newLevel;
+    historyCount = 0;
+    historyNext = 0;
+    return true;
+}
@@ -0,0 +1,38 @@
+#ifndef _framebudget
+#define _framebudget
+
+#include <chrono>
+#include <stdint.h>
+
+// Quality levels modes can render at, 0 is the cheapest
+#define QUALITY_LEVELS 3
+// Frames averaged before the quality may change again
+#define FRAME_BUDGET_HISTORY 16
+
+// Measures how long frames take to render and picks a quality level that
+// keeps them inside the budget. Quality drops when the average of the last
+// frames is over the budget, and only comes back when it is well under.
+// The history restarts after every step, so one step settles before the
+// next is taken.
+class FrameBudget
+{
+    private:
+        typedef std::chrono::steady_clock Clock;
+
+        int budgetMicros;
+        int raisePercent;
+        int level;
+
+        Clock::time_point frameStart;
+        int history[FRAME_BUDGET_HISTORY];
+        int historyCount;
+        int historyNext;
+    public:
+        FrameBudget(int budgetMicros, int raisePercent);
+
+        void Begin();
+        bool End();
+        inline int Level() const { return level; }
+};
+
+#endif
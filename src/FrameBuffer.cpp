@@ -0,0 +1,66 @@
+#include "FrameBuffer.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+using namespace rgb_matrix;
+
+FrameBuffer::FrameBuffer(int width, int height)
+{
+    w = width;
+    h = height;
+    isDirty = true;
+    isOwned = true;
+    if (posix_memalign((void **)&pixels, FRAMEBUFFER_ALIGN, sizeof(Pixel) * w * h) != 0)
+    {
+        pixels = NULL;
+        w = 0;
+        h = 0;
+        return;
+    }
+    Clear();
+}
+
+FrameBuffer::FrameBuffer(int width, int height, Pixel *memory)
+{
+    w = width;
+    h = height;
+    isDirty = true;
+    isOwned = false;
+    pixels = memory;
+}
+
+FrameBuffer::~FrameBuffer()
+{
+    if (isOwned)
+    {
+        free(pixels);
+    }
+}
+
+void FrameBuffer::SetPixel(int x, int y, uint8_t red, uint8_t green, uint8_t blue)
+{
+    if (x < 0 || x >= w || y < 0 || y >= h)
+    {
+        return;
+    }
+    Set(x, y, red, green, blue);
+}
+
+void FrameBuffer::Clear()
+{
+    memset(pixels, 0, sizeof(Pixel) * w * h);
+}
+
+void FrameBuffer::Fill(uint8_t red, uint8_t green, uint8_t blue)
+{
+    Fill(MakePixel(red, green, blue));
+}
+
+void FrameBuffer::Fill(Pixel p)
+{
+    for (int i = 0; i < w * h; i++)
+    {
+        pixels[i] = p;
+    }
+}
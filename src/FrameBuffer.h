@@ -0,0 +1,66 @@
+#ifndef _framebuffer
+#define _framebuffer
+
+#include "led-matrix.h"
+
+#include <stdint.h>
+
+// Framebuffer memory starts on a cache line boundary
+#define FRAMEBUFFER_ALIGN 64
+
+using namespace rgb_matrix;
+
+// One 32 bit word per pixel. Alpha is only used when layers are
+// composited, the panel ignores it.
+struct Pixel
+{
+    uint8_t r, g, b, a;
+};
+
+inline Pixel MakePixel(uint8_t red, uint8_t green, uint8_t blue, uint8_t alpha = 255)
+{
+    Pixel p = { red, green, blue, alpha };
+    return p;
+}
+
+// Linear RGB framebuffer every mode renders into.
+// It is also a Canvas so the library text and shape helpers can draw on it,
+// but hot paths should write rows directly or use the inline Set.
+class FrameBuffer : public Canvas
+{
+    private:
+        int w, h;
+        Pixel *pixels;
+        bool isDirty;
+        bool isOwned;
+    public:
+        FrameBuffer(int width, int height);
+        // Over memory owned by someone else, like a shared memory slot
+        FrameBuffer(int width, int height, Pixel *memory);
+        virtual ~FrameBuffer();
+
+        virtual int width() const { return w; }
+        virtual int height() const { return h; }
+        virtual void SetPixel(int x, int y, uint8_t red, uint8_t green, uint8_t blue);
+        virtual void Clear();
+        virtual void Fill(uint8_t red, uint8_t green, uint8_t blue);
+        void Fill(Pixel p);
+
+        // Unchecked write, caller keeps x and y in bounds
+        inline void Set(int x, int y, uint8_t red, uint8_t green, uint8_t blue)
+        {
+            pixels[y * w + x] = MakePixel(red, green, blue);
+        }
+
+        inline Pixel * Row(int y) { return pixels + y * w; }
+        inline const Pixel * Row(int y) const { return pixels + y * w; }
+        inline Pixel * Data() { return pixels; }
+        inline const Pixel * Data() const { return pixels; }
+
+        // Set by whoever draws, so unchanged frames are not presented again
+        inline void MarkDirty() { isDirty = true; }
+        inline void ClearDirty() { isDirty = false; }
+        inline bool IsDirty() const { return isDirty; }
+};
+
+#endif
@@ -0,0 +1,125 @@
+#include "FrameCodec.h"
+
+using namespace rgb_matrix;
+
+// Walks the pixels of a frame placed inside a bigger one in row order
+class PixelCursor
+{
+    private:
+        FrameBuffer *frame;
+        int x, y, width, left, top;
+        int index, count;
+        Pixel *row;
+    public:
+        PixelCursor(FrameBuffer *frame, int left, int top, int width, int height)
+        {
+            this->frame = frame;
+            this->left = left;
+            this->top = top;
+            this->width = width;
+            x = 0;
+            y = 0;
+            index = 0;
+            count = width * height;
+            row = frame->Row(top) + left;
+        }
+
+        inline bool IsDone() const { return index >= count; }
+        inline uint32_t Remaining() const { return count - index; }
+        inline Pixel & Current() { return row[x]; }
+
+        // Never past the end, callers check against Remaining first
+        void Skip(uint32_t pixels)
+        {
+            pixels = pixels < Remaining() ? pixels : Remaining();
+            index += pixels;
+            if (index >= count)
+            {
+                return;
+            }
+            x += pixels;
+            if (x >= width)
+            {
+                y += x / width;
+                x %= width;
+                row = frame->Row(top + y) + left;
+            }
+        }
+};
+
+static bool readVarint(const uint8_t *payload, size_t length, size_t *at, uint32_t *value)
+{
+    *value = 0;
+    for (int shift = 0; shift < 32; shift += 7)
+    {
+        if (*at >= length)
+        {
+            return false;
+        }
+        uint8_t b = payload[(*at)++];
+        *value |= (uint32_t)(b & 0x7F) << shift;
+        if ((b & 0x80) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Returns false on a payload that doesn't fit the frame, without writing
+// outside the area being decoded
+bool DecodeFrame(FrameRecordType type, const uint8_t *payload, size_t length, int width, int height, FrameBuffer *frame, int x, int y)
+{
+    if (x < 0 || y < 0 || x + width > frame->width() || y + height > frame->height())
+    {
+        return false;
+    }
+
+    PixelCursor cursor(frame, x, y, width, height);
+    size_t at = 0;
+
+    if (type == KeyRecord)
+    {
+        while (at + 4 <= length && !cursor.IsDone())
+        {
+            int run = payload[at] + 1;
+            Pixel p = MakePixel(payload[at + 1], payload[at + 2], payload[at + 3]);
+            at += 4;
+            for (int i = 0; i < run && !cursor.IsDone(); i++)
+            {
+                cursor.Current() = p;
+                cursor.Skip(1);
+            }
+        }
+        return at == length && cursor.IsDone();
+    }
+
+    while (at < length)
+    {
+        uint32_t same, changed;
+        if (!readVarint(payload, length, &at, &same) || !readVarint(payload, length, &at, &changed))
+        {
+            return false;
+        }
+        // Counts come from the file, they may not run past the frame
+        if (same > cursor.Remaining())
+        {
+            return false;
+        }
+        cursor.Skip(same);
+        if (changed > cursor.Remaining() || changed > (length - at) / 3)
+        {
+            return false;
+        }
+        for (uint32_t i = 0; i < changed; i++)
+        {
+            Pixel &p = cursor.Current();
+            p.r ^= payload[at];
+            p.g ^= payload[at + 1];
+            p.b ^= payload[at + 2];
+            at += 3;
+            cursor.Skip(1);
+        }
+    }
+    return true;
+}
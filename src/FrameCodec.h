@@ -0,0 +1,23 @@
+#ifndef _framecodec
+#define _framecodec
+
+#include "FrameBuffer.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+using namespace rgb_matrix;
+
+// Frame payloads shared by recordings and animation packs, see
+// FrameRecorder.h for how they are laid out
+enum FrameRecordType
+{
+    KeyRecord,
+    DeltaRecord
+};
+
+// Decode a payload of a width x height frame into the frame at x, y.
+// A delta is applied to whatever the frame already shows there.
+bool DecodeFrame(FrameRecordType type, const uint8_t *payload, size_t length, int width, int height, FrameBuffer *frame, int x, int y);
+
+#endif
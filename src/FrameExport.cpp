@@ -0,0 +1,184 @@
+#include "FrameExport.h"
+
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <new>
+
+using namespace rgb_matrix;
+
+static uint64_t nowMicros()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+FrameExport::FrameExport(const char *name, int width, int height)
+{
+    this->name = name;
+    header = NULL;
+    writing = 0;
+    for (int i = 0; i < FRAME_EXPORT_SLOTS; i++)
+    {
+        slots[i] = NULL;
+    }
+
+    size_t pixelOffset = (sizeof(FrameExportHeader) + FRAMEBUFFER_ALIGN - 1) / FRAMEBUFFER_ALIGN * FRAMEBUFFER_ALIGN;
+    size = pixelOffset + sizeof(Pixel) * width * height * FRAME_EXPORT_SLOTS;
+
+    int fd = shm_open(name, O_CREAT | O_RDWR | O_TRUNC, 0644);
+    if (fd < 0)
+    {
+        perror("shm_open()");
+        return;
+    }
+    if (ftruncate(fd, size) < 0)
+    {
+        perror("ftruncate()");
+        close(fd);
+        shm_unlink(name);
+        return;
+    }
+    void *memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED)
+    {
+        perror("mmap()");
+        shm_unlink(name);
+        return;
+    }
+
+    header = new (memory) FrameExportHeader();
+    header->magic = FRAME_EXPORT_MAGIC;
+    header->version = FRAME_EXPORT_VERSION;
+    header->width = width;
+    header->height = height;
+    header->slotCount = FRAME_EXPORT_SLOTS;
+    header->pixelOffset = pixelOffset;
+    header->frames.store(0);
+
+    Pixel *pixels = (Pixel *)((uint8_t *)memory + pixelOffset);
+    for (int i = 0; i < FRAME_EXPORT_SLOTS; i++)
+    {
+        header->slots[i].sequence.store(0);
+        header->slots[i].timestampUs = 0;
+        slots[i] = new FrameBuffer(width, height, pixels + i * width * height);
+    }
+}
+
+FrameExport::~FrameExport()
+{
+    for (int i = 0; i < FRAME_EXPORT_SLOTS; i++)
+    {
+        delete slots[i];
+    }
+    if (header != NULL)
+    {
+        munmap(header, size);
+        shm_unlink(name);
+    }
+}
+
+// Slot after the newest frame, readers still copying it see a torn frame
+FrameBuffer * FrameExport::Acquire()
+{
+    uint64_t frame = header->frames.load(std::memory_order_relaxed);
+    writing = frame % FRAME_EXPORT_SLOTS;
+    header->slots[writing].sequence.store(2 * frame + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    return slots[writing];
+}
+
+void FrameExport::Publish()
+{
+    uint64_t frame = header->frames.load(std::memory_order_relaxed);
+    header->slots[writing].timestampUs = nowMicros();
+    header->slots[writing].sequence.store(2 * frame + 2, std::memory_order_release);
+    header->frames.store(frame + 1, std::memory_order_release);
+}
+
+FrameExportReader::FrameExportReader(const char *name)
+{
+    header = NULL;
+    size = 0;
+    lastFrame = 0;
+
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0)
+    {
+        return;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(FrameExportHeader))
+    {
+        close(fd);
+        return;
+    }
+    void *memory = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED)
+    {
+        return;
+    }
+
+    const FrameExportHeader *h = (const FrameExportHeader *)memory;
+    uint64_t pixelsEnd = h->pixelOffset + (uint64_t)sizeof(Pixel) * h->width * h->height * h->slotCount;
+    if (h->magic != FRAME_EXPORT_MAGIC || h->version != FRAME_EXPORT_VERSION ||
+        h->slotCount == 0 || h->slotCount > FRAME_EXPORT_SLOTS || pixelsEnd > (uint64_t)st.st_size)
+    {
+        munmap(memory, st.st_size);
+        return;
+    }
+    header = h;
+    size = st.st_size;
+}
+
+FrameExportReader::~FrameExportReader()
+{
+    if (header != NULL)
+    {
+        munmap((void *)header, size);
+    }
+}
+
+// Copy the newest frame if there is one since the last read, frames in
+// between are skipped. Returns false when there is nothing new or the
+// frame was overwritten while copying.
+bool FrameExportReader::Read(Pixel *pixels, uint64_t *frame, uint64_t *timestampUs)
+{
+    uint64_t frames = header->frames.load(std::memory_order_acquire);
+    if (frames == 0 || frames == lastFrame)
+    {
+        return false;
+    }
+
+    const FrameExportHeader::Slot &slot = header->slots[(frames - 1) % header->slotCount];
+    uint64_t before = slot.sequence.load(std::memory_order_acquire);
+    if (before != 2 * (frames - 1) + 2)
+    {
+        return false;
+    }
+
+    size_t count = (size_t)header->width * header->height;
+    const Pixel *src = (const Pixel *)((const uint8_t *)header + header->pixelOffset) + ((frames - 1) % header->slotCount) * count;
+    memcpy(pixels, src, sizeof(Pixel) * count);
+    uint64_t timestamp = slot.timestampUs;
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.sequence.load(std::memory_order_relaxed) != before)
+    {
+        return false;
+    }
+
+    lastFrame = frames;
+    *frame = frames - 1;
+    *timestampUs = timestamp;
+    return true;
+}
@@ -0,0 +1,80 @@
+#ifndef _frameexport
+#define _frameexport
+
+#include "FrameBuffer.h"
+
+#include <atomic>
+#include <stdint.h>
+
+// Frames kept in the ring, a reader has this many frames to copy one out
+#define FRAME_EXPORT_SLOTS 4
+// Shared memory every composed frame is published to, see ExportView
+#define FRAME_EXPORT_NAME "/gamematrix-frames"
+#define FRAME_EXPORT_MAGIC 0x474D4658
+#define FRAME_EXPORT_VERSION 1
+
+using namespace rgb_matrix;
+
+// Start of the shared memory object, slot pixels follow at pixelOffset,
+// each slot width * height Pixels in row order.
+// A slot's sequence is odd while it is written and even once it holds a
+// frame. To read one, load its sequence, copy the pixels and load the
+// sequence again. If the two differ or are odd the copy is torn, the
+// writer never waits for readers.
+struct FrameExportHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    uint32_t slotCount;
+    uint32_t pixelOffset;
+    // Frames published so far, the newest is in slot (frames - 1) % slotCount
+    std::atomic<uint64_t> frames;
+    struct Slot
+    {
+        std::atomic<uint64_t> sequence;
+        uint64_t timestampUs;
+    } slots[FRAME_EXPORT_SLOTS];
+};
+
+// Publishes frames through a POSIX shared memory ring.
+// Frames are rendered straight into the ring, Acquire hands out the next
+// slot as a FrameBuffer and Publish makes it visible to readers.
+class FrameExport
+{
+    private:
+        const char *name;
+        FrameExportHeader *header;
+        size_t size;
+        FrameBuffer *slots[FRAME_EXPORT_SLOTS];
+        int writing;
+    public:
+        FrameExport(const char *name, int width, int height);
+        ~FrameExport();
+
+        inline bool IsOpen() const { return header != NULL; }
+
+        FrameBuffer * Acquire();
+        void Publish();
+};
+
+// Attaches to a FrameExport from another process
+class FrameExportReader
+{
+    private:
+        const FrameExportHeader *header;
+        size_t size;
+        uint64_t lastFrame;
+    public:
+        FrameExportReader(const char *name);
+        ~FrameExportReader();
+
+        inline bool IsOpen() const { return header != NULL; }
+        inline int Width() const { return header->width; }
+        inline int Height() const { return header->height; }
+
+        bool Read(Pixel *pixels, uint64_t *frame, uint64_t *timestampUs);
+};
+
+#endif
@@ -0,0 +1,90 @@
+#include "FramePipeline.h"
+
+#include <string.h>
+
+using namespace rgb_matrix;
+
+#define FRESH_FRAME 0x100
+#define FRAME_INDEX 0xFF
+
+FramePipeline::FramePipeline(int width, int height, const Presenter &present)
+{
+    this->present = present;
+    for (int i = 0; i < PIPELINE_FRAMES; i++)
+    {
+        frames[i] = new FrameBuffer(width, height);
+        fractions[i] = 1;
+    }
+    back = 0;
+    ready = 1;
+    front = 2;
+    isStopping = false;
+    presenter = std::thread(&FramePipeline::run, this);
+}
+
+FramePipeline::~FramePipeline()
+{
+    {
+        std::lock_guard<std::mutex> locker(mux);
+        isStopping = true;
+    }
+    submitted.notify_one();
+    taken.notify_all();
+    presenter.join();
+
+    for (int i = 0; i < PIPELINE_FRAMES; i++)
+    {
+        delete frames[i];
+    }
+}
+
+// Wait until the last submitted frame is presenting. Input read after this
+// makes it into the very next frame.
+void FramePipeline::WaitForSlot()
+{
+    if (!(ready.load() & FRESH_FRAME))
+    {
+        return;
+    }
+    std::unique_lock<std::mutex> locker(mux);
+    taken.wait(locker, [&] { return isStopping || !(ready.load() & FRESH_FRAME); });
+}
+
+void FramePipeline::Submit(const FrameBuffer *frame, unsigned framerateFraction)
+{
+    WaitForSlot();
+
+    FrameBuffer *target = frames[back];
+    memcpy(target->Data(), frame->Data(), sizeof(Pixel) * target->width() * target->height());
+    fractions[back] = framerateFraction;
+    back = ready.exchange(back | FRESH_FRAME) & FRAME_INDEX;
+
+    // Taking the lock orders this against the presenter going to sleep
+    {
+        std::lock_guard<std::mutex> locker(mux);
+    }
+    submitted.notify_one();
+}
+
+void FramePipeline::run()
+{
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> locker(mux);
+            submitted.wait(locker, [&] { return isStopping || (ready.load() & FRESH_FRAME); });
+            if (isStopping)
+            {
+                return;
+            }
+        }
+
+        front = ready.exchange(front) & FRAME_INDEX;
+        {
+            std::lock_guard<std::mutex> locker(mux);
+        }
+        taken.notify_one();
+
+        present(frames[front], fractions[front]);
+    }
+}
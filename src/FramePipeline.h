@@ -0,0 +1,56 @@
+#ifndef _framepipeline
+#define _framepipeline
+
+#include "FrameBuffer.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// Frames in flight: one being rendered, one waiting and one presenting
+#define PIPELINE_FRAMES 3
+
+using namespace rgb_matrix;
+
+// Presents frames on a thread of its own, so the main loop reads input and
+// renders the next frame while the last one is uploaded and waits for
+// vsync.
+// Frames are handed over through a triple buffer: Submit copies the frame
+// into the free buffer and swaps it into the ready slot with one atomic
+// exchange, the presenter swaps it out the same way. Neither side ever
+// waits for the other to finish with a buffer. The mutex only puts a side
+// to sleep when there is nothing for it to do.
+// Submitting waits for the frame before to be taken, so rendering runs at
+// most one frame ahead and frame counted timers keep the display's pace.
+class FramePipeline
+{
+    public:
+        typedef std::function<void(const FrameBuffer *frame, unsigned framerateFraction)> Presenter;
+    private:
+        Presenter present;
+
+        FrameBuffer *frames[PIPELINE_FRAMES];
+        unsigned fractions[PIPELINE_FRAMES];
+        // Index of the waiting frame, with the fresh bit while not taken
+        std::atomic<int> ready;
+        int back;
+        int front;
+
+        std::mutex mux;
+        std::condition_variable submitted;
+        std::condition_variable taken;
+        bool isStopping;
+        std::thread presenter;
+
+        void run();
+    public:
+        FramePipeline(int width, int height, const Presenter &present);
+        ~FramePipeline();
+
+        void WaitForSlot();
+        void Submit(const FrameBuffer *frame, unsigned framerateFraction);
+};
+
+#endif
@@ -0,0 +1,222 @@
+#include "FrameRecorder.h"
+
+#include <string.h>
+#include <time.h>
+
+using namespace rgb_matrix;
+
+// Output is written in big chunks to spare the SD card
+#define RECORDER_FILE_BUFFER (1 << 20)
+
+static uint64_t nowMicros()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+FrameRecorder::FrameRecorder(const char *path, int width, int height, int keyframeInterval)
+{
+    this->keyframeInterval = keyframeInterval;
+    queueHead = 0;
+    queueCount = 0;
+    dropped = 0;
+    isStopping = false;
+    framesSinceKey = 0;
+    previous = NULL;
+    startUs = nowMicros();
+    for (int i = 0; i < RECORDER_QUEUE_FRAMES; i++)
+    {
+        queue[i].pixels = NULL;
+    }
+
+    file = fopen(path, "wb");
+    if (file == NULL)
+    {
+        perror("fopen()");
+        return;
+    }
+    setvbuf(file, NULL, _IOFBF, RECORDER_FILE_BUFFER);
+
+    uint32_t header[4] = { RECORDER_MAGIC, RECORDER_VERSION, (uint32_t)width, (uint32_t)height };
+    fwrite(header, sizeof(header), 1, file);
+
+    for (int i = 0; i < RECORDER_QUEUE_FRAMES; i++)
+    {
+        queue[i].pixels = new FrameBuffer(width, height);
+    }
+    previous = new FrameBuffer(width, height);
+    payload.reserve(sizeof(Pixel) * width * height);
+    encoder = std::thread(&FrameRecorder::encode, this);
+}
+
+FrameRecorder::~FrameRecorder()
+{
+    if (file != NULL)
+    {
+        {
+            std::lock_guard<std::mutex> locker(mux);
+            isStopping = true;
+        }
+        ready.notify_one();
+        encoder.join();
+
+        if (dropped > 0)
+        {
+            fprintf(stderr, "Recorder dropped %d frames\n", dropped);
+        }
+        fclose(file);
+    }
+
+    for (int i = 0; i < RECORDER_QUEUE_FRAMES; i++)
+    {
+        delete queue[i].pixels;
+    }
+    delete previous;
+}
+
+// Called on the render thread, costs one frame copy. When the encoder is
+// behind the frame is dropped and the next delta covers it.
+void FrameRecorder::Record(const FrameBuffer *frame)
+{
+    if (file == NULL)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> locker(mux);
+    if (queueCount == RECORDER_QUEUE_FRAMES)
+    {
+        dropped++;
+        return;
+    }
+
+    QueuedFrame &slot = queue[(queueHead + queueCount) % RECORDER_QUEUE_FRAMES];
+    memcpy(slot.pixels->Data(), frame->Data(), sizeof(Pixel) * frame->width() * frame->height());
+    slot.timestampUs = nowMicros() - startUs;
+    queueCount++;
+    ready.notify_one();
+}
+
+void FrameRecorder::encode()
+{
+    while (true)
+    {
+        QueuedFrame slot;
+        {
+            std::unique_lock<std::mutex> locker(mux);
+            ready.wait(locker, [&] { return isStopping || queueCount > 0; });
+            if (queueCount == 0)
+            {
+                return;
+            }
+            slot = queue[queueHead];
+        }
+
+        // The slot is not handed out again until it is released below
+        if (framesSinceKey == 0)
+        {
+            encodeKey(slot.pixels);
+            write(KeyRecord, slot.timestampUs);
+        }
+        else
+        {
+            encodeDelta(slot.pixels);
+            write(DeltaRecord, slot.timestampUs);
+        }
+        framesSinceKey = (framesSinceKey + 1) % keyframeInterval;
+        memcpy(previous->Data(), slot.pixels->Data(), sizeof(Pixel) * previous->width() * previous->height());
+
+        std::lock_guard<std::mutex> locker(mux);
+        queueHead = (queueHead + 1) % RECORDER_QUEUE_FRAMES;
+        queueCount--;
+    }
+}
+
+static inline bool isSameColor(const Pixel &p, const Pixel &q)
+{
+    return p.r == q.r && p.g == q.g && p.b == q.b;
+}
+
+void FrameRecorder::encodeKey(const FrameBuffer *frame)
+{
+    payload.clear();
+    const Pixel *p = frame->Data();
+    int count = frame->width() * frame->height();
+    int i = 0;
+    while (i < count)
+    {
+        int run = 1;
+        while (i + run < count && run < 256 && isSameColor(p[i + run], p[i]))
+        {
+            run++;
+        }
+        payload.push_back(run - 1);
+        payload.push_back(p[i].r);
+        payload.push_back(p[i].g);
+        payload.push_back(p[i].b);
+        i += run;
+    }
+}
+
+void FrameRecorder::encodeDelta(const FrameBuffer *frame)
+{
+    payload.clear();
+    const Pixel *p = frame->Data();
+    const Pixel *q = previous->Data();
+    int count = frame->width() * frame->height();
+    int i = 0;
+    while (i < count)
+    {
+        int same = 0;
+        while (i + same < count && isSameColor(p[i + same], q[i + same]))
+        {
+            same++;
+        }
+        if (i + same == count)
+        {
+            break;
+        }
+        i += same;
+
+        int changed = 0;
+        while (i + changed < count && !isSameColor(p[i + changed], q[i + changed]))
+        {
+            changed++;
+        }
+
+        putVarint(same);
+        putVarint(changed);
+        for (int k = i; k < i + changed; k++)
+        {
+            payload.push_back(p[k].r ^ q[k].r);
+            payload.push_back(p[k].g ^ q[k].g);
+            payload.push_back(p[k].b ^ q[k].b);
+        }
+        i += changed;
+    }
+}
+
+// Seven bits per byte, high bit set while more follow
+void FrameRecorder::putVarint(uint32_t value)
+{
+    while (value >= 0x80)
+    {
+        payload.push_back((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    payload.push_back(value);
+}
+
+void FrameRecorder::write(FrameRecordType type, uint64_t timestampUs)
+{
+    uint8_t recordType = type;
+    uint32_t length = payload.size();
+    fwrite(&recordType, sizeof(recordType), 1, file);
+    fwrite(&timestampUs, sizeof(timestampUs), 1, file);
+    fwrite(&length, sizeof(length), 1, file);
+    if (length > 0)
+    {
+        fwrite(&payload[0], 1, length, file);
+    }
+}
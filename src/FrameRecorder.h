@@ -0,0 +1,70 @@
+#ifndef _framerecorder
+#define _framerecorder
+
+#include "FrameBuffer.h"
+#include "FrameCodec.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <stdint.h>
+#include <stdio.h>
+#include <thread>
+#include <vector>
+
+// Frames waiting to be encoded, more are dropped rather than waited for
+#define RECORDER_QUEUE_FRAMES 8
+#define RECORDER_MAGIC 0x43524D47
+#define RECORDER_VERSION 1
+
+using namespace rgb_matrix;
+
+// Records presented frames to a file on a background thread.
+// The file starts with magic, version, width and height as uint32. Every
+// frame follows as a record: uint8 type, uint64 microseconds since the
+// recording started and uint32 payload length.
+// A keyframe payload is runs of identical pixels, each a uint8 run length
+// minus one and the r, g, b bytes. A delta payload XORs the frame with the
+// previous one and stores only the changed pixels, as pairs of varint
+// counts of unchanged and changed pixels, each changed pixel followed by
+// its XORed r, g, b. An unchanged frame costs a record header.
+class FrameRecorder
+{
+    private:
+        struct QueuedFrame
+        {
+            FrameBuffer *pixels;
+            uint64_t timestampUs;
+        };
+
+        FILE *file;
+        int keyframeInterval;
+        uint64_t startUs;
+
+        QueuedFrame queue[RECORDER_QUEUE_FRAMES];
+        int queueHead;
+        int queueCount;
+        int dropped;
+        bool isStopping;
+        std::mutex mux;
+        std::condition_variable ready;
+        std::thread encoder;
+
+        // Encoder thread state
+        FrameBuffer *previous;
+        std::vector<uint8_t> payload;
+        int framesSinceKey;
+
+        void encode();
+        void encodeKey(const FrameBuffer *frame);
+        void encodeDelta(const FrameBuffer *frame);
+        void putVarint(uint32_t value);
+        void write(FrameRecordType type, uint64_t timestampUs);
+    public:
+        FrameRecorder(const char *path, int width, int height, int keyframeInterval);
+        ~FrameRecorder();
+
+        inline bool IsOpen() const { return file != NULL; }
+        void Record(const FrameBuffer *frame);
+};
+
+#endif
@@ -2,13 +2,29 @@
 #include "Tetris.h"
 #include "Inputs.h"
 #include "Menu.h"
+#include "CanvasPool.h"
+#include "Compositor.h"
+#include "TileRenderer.h"
+#include "FrameBudget.h"
+#include "FramePipeline.h"
+#include "FrameExport.h"
+#include "FrameRecorder.h"
+#include "AnimationPlayer.h"
+#include "TerminalPreview.h"
+#include "ColorStage.h"
+#include "PowerGovernor.h"
+#include "Plasma.h"
+#include "Life.h"
+#include "Particles.h"
+#include "Fireworks.h"
+#include "Waterfall.h"
+#include "SpectrumFeed.h"
 
 // #include "Audio/AlsaInput.h"
 // #include "Audio/WaveletBpmDetector.h"
 // #include "Audio/SlidingMedian.h"
 // #include "Audio/FFTData.h"
 
-#include "pixel-mapper.h"
 #include "graphics.h"
 
 #include <unistd.h>
@@ -18,12 +34,51 @@
 #include <signal.h>
 #include <termios.h>
 #include <string>
+#include <string.h>
+#include <vector>
 
 #include <wiringPi.h>
 #include <mcp23017.h>
 
-#define PI 3.14159265
-#define PLASMA_BASE_COUNT 30
+// Quarter turns clockwise the panels are mounted at
+#define DISPLAY_ROTATION 2
+// Panel refresh limit, and how many refreshes each presented frame lasts
+#define REFRESH_RATE_HZ 120
+#define FRAMERATE_FRACTION 2
+// Idle passes wait as long as a presented frame would, so frame counted
+// timers like Tetris gravity keep the same pace
+#define IDLE_SLEEP_US (1000000 * FRAMERATE_FRACTION / REFRESH_RATE_HZ)
+// Output color. Gamma only estimates the current, the library's luminance
+// correction applies it unless dithering
+#define DISPLAY_GAMMA 2.2f
+#define DISPLAY_BRIGHTNESS 100
+#define DISPLAY_KELVIN 6500
+// PWM bits to temporally dither down to, 0 keeps the library default.
+// Fewer bits refresh faster, dithering hides the missing levels but needs
+// every frame presented, even when nothing was drawn.
+#define DITHER_PWM_BITS 0
+// After this long without input or a large change the display dims, shows
+// fewer frames and input is polled less often
+#define IDLE_AFTER_SECONDS 60
+#define IDLE_BRIGHTNESS 40
+#define IDLE_CHANGE_PERCENT 10
+#define IDLE_FRAMERATE_FRACTION 12
+#define IDLE_POLL_US 50000
+// Threads rendering bands of big frames, the library keeps the last core
+// for refreshing the panels
+#define RENDER_THREADS 3
+// Rendering a frame may take this much of a frame period before effects
+// drop quality, and has to fall under the raise percent of it to get back
+#define QUALITY_BUDGET_PERCENT 50
+#define QUALITY_RAISE_PERCENT 60
+// Recordings store a full frame this often, deltas in between
+#define RECORD_KEYFRAME_INTERVAL 600
+// Estimated draw of one LED channel fully on, and what the PSU can supply
+#define CHANNEL_MICROAMPS 1300
+#define POWER_BUDGET_MA 8000
+// Frame size previewed in the terminal when there is no panel
+#define PREVIEW_WIDTH 64
+#define PREVIEW_HEIGHT 64
 
 using namespace rgb_matrix;
 using rgb_matrix::RGBMatrix;
@@ -33,7 +88,12 @@ enum MatrixMode {
 	MenuMode,
 	TetrisMode,
 	//AnimationMode,
-	ClockMode
+	ClockMode,
+	TickerMode,
+	PlaybackMode,
+	LifeMode,
+	FireworksMode,
+	WaterfallMode
 };
 static MatrixMode matrixMode;
 
@@ -140,222 +200,41 @@ void disableTerminalInput()
 	perror ("tcsetattr ~ICANON");
 }
 
-static void getArcadeInput()
+static bool hasInput()
 {
-	int i, input;
-	for (i = 0; i < TOTAL_INPUTS; i++)
+	for (int i = 0; i < TOTAL_INPUTS; i++)
 	{
-		input = digitalRead(GPIO_OFFSET + i);
-
-		if (input == 0)
+		if (inputs[i])
 		{
-			inputs[i] = true;
+			return true;
 		}
 	}
+	return false;
 }
 
-const int mapSize = 64;
-int heightMap1[mapSize * mapSize];
-int heightMap2[mapSize * mapSize];
-int dx1, dy1, dx2, dy2;
-int plasmaCount;
-int plasmaCountTarget;
-bool prevInputs[TOTAL_INPUTS];
-Color palette[256];
-Color palette1[256];
-Color palette2[256];
-bool prevPaletteDirection;
-
-double distance(double x, double y)
-{
-	return sqrt(x * x + y * y);
-}
-
-void interpolate(Color* c, Color c1, Color c2, double f)
-{
-	c->r = floor(c1.r + (c2.r - c1.r) * f);
-	c->g = floor(c1.g + (c2.g - c1.g) * f);
-	c->b = floor(c1.b + (c2.b - c1.b) * f);
-}
-
-Color randomColor()
-{
-	Color c;
-	c.r = floor(rand() * 255);
-	c.g = floor(rand() * 255);
-	c.b = floor(rand() * 255);
-	return c;
-}
-
-void makeRandomPalette(Color *palette)
-{
-	Color c1 = randomColor();
-	Color c2 = randomColor();
-	Color c3 = randomColor();
-	Color c4 = randomColor();
-	Color c5 = randomColor();
-
-	 for (int i = 0; i < 64; i++) {
-        double f = i / 64;
-        interpolate(&palette[i], c1, c2, f);
-      }
-
-      for (int i = 64; i < 128; i++) {
-        double f = (i - 64) / 64;
-        interpolate(&palette[i], c2, c3, f);
-      }
-
-      for (int i = 128; i < 192; i++) {
-        double f = (i - 128) / 64;
-        interpolate(&palette[i], c3, c4, f);
-      }
-
-      for (int i = 192; i < 256; i++) {
-        double f = (i - 192) / 64;
-        interpolate(&palette[i], c4, c5, f);
-      }
-}
-
-void InitPlasma()
+static void getArcadeInput()
 {
-	dx1 = 0;
-	dy1 = 0;
-	dx2 = 0;
-	dy2 = 0;
-
-	uint64_t plasmaCount = 0;
-	plasmaCountTarget = PLASMA_BASE_COUNT;
-
-	makeRandomPalette(palette);
-	makeRandomPalette(palette1);
-	makeRandomPalette(palette2);
-
-	prevPaletteDirection = true;
-
-	for (int u = 0; u < mapSize; u++)
+	int i, input;
+	for (i = 0; i < TOTAL_INPUTS; i++)
 	{
-		for (int v = 0; v < mapSize; v++)
-		{
-			int i = u * mapSize + v;
-
-			double cx = u - mapSize / 2;
-			double cy = v - mapSize / 2;
-
-			double d = distance(cx, cy);
-
-			double stretch = (3 * PI) / (mapSize / 2);
-
-			double ripple = sin(d * stretch);
-
-			double normalized = (ripple + 1) / 2;
-
-			heightMap1[i] = floor(normalized * 128);
-		}
-	}
+		input = digitalRead(GPIO_OFFSET + i);
 
-	for (int u = 0; u < mapSize; u++)
-	{
-		for (int v = 0; v < mapSize; v++)
+		if (input == 0)
 		{
-			int i = u * mapSize + v;
-
-			double cx = u - mapSize / 2;
-			double cy = v - mapSize / 2;
-
-			double d1 = distance(0.8 * cx, 1.3 * cy) * 0.022;
-        	double d2 = distance(1.35 * cx, 0.45 * cy) * 0.022;
-
-			double s = sin(d1);
-			double c = sin(d2);
-			double h = s + c;
-
-			double normalized = (h + 2) / 4;
-
-			heightMap2[i] = floor(normalized * 127);
+			inputs[i] = true;
 		}
 	}
 }
 
-int PlasmaLoop(RGBMatrix* matrix, volatile bool *inputs)
+// Which layers each mode shows, a paused game stays under the menu
+static void showLayers(Compositor *compositor, MatrixMode mode, bool isGamePaused)
 {
-	// Proccess inputs on button down
-    if (inputs[UpStick] && !prevInputs[UpStick])
-    {
-        // Change speed
-    }
-
-	if (inputs[DownStick] && !prevInputs[DownStick])
-    {
-        // Change speed
-    }
-    
-    if (inputs[MenuButton] && !prevInputs[MenuButton])
-    {
-        for (int i = 0; i < TOTAL_INPUTS; i++)
-        {
-            prevInputs[i] = inputs[i];
-            inputs[i] = false;
-        }
-        
-        return -1;
-    }
-
-    for (int i = 0; i < TOTAL_INPUTS; i++)
-    {
-        prevInputs[i] = inputs[i];
-        inputs[i] = false;
-    }
-
-	// Move height map
-	if (plasmaCount++ % plasmaCountTarget == 0)
-	{
-		dx1 = floor((((cos(0.0002 + 0.4 + PI) + 1)/2) * mapSize) / 2);
-		dy1 = floor((((cos(0.0003 - 0.1) + 1) / 2) * mapSize) / 2);
-		dx2 = floor((((cos(-0.0002 + 1.2) + 1) / 2) * mapSize) / 2);
-		dy2 = floor((((cos( -0.0003 - 0.8 + PI) + 1) / 2) * mapSize) / 2);
-	}
-
-	// Update palette
-	double x = plasmaCount * 0.0005;
-	double inter = (cos(x) + 1) / 2;
-
-	bool direction = -sin(x) >= 0;
-	if (prevPaletteDirection != direction) {
-	prevPaletteDirection = direction;
-		if (direction == false) {
-			makeRandomPalette(palette1);
-		} else {
-			makeRandomPalette(palette2);
-		}
-	}
-
-	// create interpolated palette for current frame
-	for (int i = 0; i < 256; i++) {
-		interpolate(&palette[i], palette1[i], palette2[i], inter);
-	}
-
-	FrameCanvas *canvas = matrix->CreateFrameCanvas();
-
-	for (int u = 0; u < mapSize; u++)
-	{
-		for (int v = 0; v < mapSize; v++)
-		{
-			int i = (u + dy1) * mapSize + (v + dx1);
-			int k = (u + dy2) * mapSize + (v + dx2);
-
-			int h = heightMap1[i] + heightMap2[k];
-
-			if ( h > 255 )
-			{
-				h = 255;
-			}
-
-			canvas->SetPixel(u, v, palette[h].r, palette[h].g, palette[h].b);
-		}
-	}
-
-	matrix->SwapOnVSync(canvas, 2U);
-	return 0;
+	// Plasma draws into the background, shown again with AnimationMode
+	compositor->SetVisible(BackgroundLayer, false);
+	compositor->SetVisible(GameLayer, mode == TetrisMode || (mode == MenuMode && isGamePaused));
+	// Tetris and fireworks draw sparks on the overlay, they add light
+	compositor->SetVisible(OverlayLayer, true);
+	compositor->SetBlend(OverlayLayer, mode == TetrisMode || mode == FireworksMode ? AddBlend : OverBlend);
 }
 
 int main(int argc, char *argv[]) 
@@ -369,9 +248,14 @@ int main(int argc, char *argv[])
 
 	defaults.parallel = 1;
 	defaults.chain_length = 4;
-	defaults.pixel_mapper_config = "U-Mapper;Rotate:180";
+	// Rotation is done in software when presenting a frame
+	defaults.pixel_mapper_config = "U-Mapper";
 
-	defaults.limit_refresh_rate_hz = 120;
+	defaults.limit_refresh_rate_hz = REFRESH_RATE_HZ;
+	if (DITHER_PWM_BITS > 0)
+	{
+		defaults.pwm_bits = DITHER_PWM_BITS;
+	}
 	defaults.show_refresh_rate = false;
 
 	rgb_matrix::RuntimeOptions rtOptions;
@@ -381,23 +265,56 @@ int main(int argc, char *argv[])
 	rtOptions.daemon = 0;
 	rtOptions.do_gpio_init = true;
 
-	RGBMatrix *matrix = RGBMatrix::CreateFromOptions(defaults, rtOptions);
-	if (matrix == NULL)
+	// Geometry defaults to four 32x32 panels folded into 64x64, the
+	// library's --led-rows, --led-cols, --led-chain, --led-parallel and
+	// --led-pixel-mapper flags change it
+	if (!rgb_matrix::ParseOptionsFromFlags(&argc, &argv, &defaults, &rtOptions))
 	{
+		fprintf(stderr, "Usage: %s [kb] [term] [record=<path>] [pack=<path>] [ticker=<text>] [options]\n", argv[0]);
+		rgb_matrix::PrintMatrixFlags(stderr, defaults, rtOptions);
 		return 1;
 	}
 
+	// term shows the frames in the terminal instead of the panels, for
+	// machines without them. Input then comes from the keyboard.
+	bool isTerminal = false;
+	for (int i = 1; i < argc; i++)
+	{
+		std::string term ("term");
+		if (term.compare(argv[i]) == 0)
+		{
+			isTerminal = true;
+		}
+	}
+
+	RGBMatrix *matrix = NULL;
+	int width = PREVIEW_WIDTH;
+	int height = PREVIEW_HEIGHT;
+	if (!isTerminal)
+	{
+		matrix = RGBMatrix::CreateFromOptions(defaults, rtOptions);
+		if (matrix == NULL)
+		{
+			return 1;
+		}
+		width = matrix->width();
+		height = matrix->height();
+	}
+
 	// It is always good to set up a signal handler to cleanly exit when we
 	// receive a CTRL-C for instance.
 	signal(SIGTERM, InterruptHandler);
 	signal(SIGINT, InterruptHandler);
 
-	wiringPiSetup();
-	mcp23017Setup(GPIO_OFFSET, 0x20);
-	for (int i = 0; i < TOTAL_INPUTS; i++)
+	if (!isTerminal)
 	{
-			pinMode(GPIO_OFFSET + i, INPUT);
-			pullUpDnControl(GPIO_OFFSET + i, PUD_UP);
+		wiringPiSetup();
+		mcp23017Setup(GPIO_OFFSET, 0x20);
+		for (int i = 0; i < TOTAL_INPUTS; i++)
+		{
+				pinMode(GPIO_OFFSET + i, INPUT);
+				pullUpDnControl(GPIO_OFFSET + i, PUD_UP);
+		}
 	}
 
 	// Init Engine Resources
@@ -416,16 +333,52 @@ int main(int argc, char *argv[])
     // using Duration = std::chrono::steady_clock::duration;
 	// SlidingMedian<float, Timestamp, Duration> slide = SlidingMedian<float, Timestamp, Duration>(std::chrono::seconds(5));
 
+	CanvasPool *pool = NULL;
+	TerminalPreview *preview = NULL;
+	if (isTerminal)
+	{
+		preview = new TerminalPreview(STDOUT_FILENO, width, height);
+	}
+	else
+	{
+		// Dithering quantizes duty, so the stage applies gamma itself
+		if (DITHER_PWM_BITS > 0)
+		{
+			matrix->set_luminance_correct(false);
+		}
+		pool = new CanvasPool(matrix, DISPLAY_ROTATION);
+	}
+	TileRenderer *tiles = new TileRenderer(RENDER_THREADS);
+	FrameExport *exporter = new FrameExport(FRAME_EXPORT_NAME, width, height);
+	Compositor *compositor = new Compositor(tiles, exporter, width, height);
+	FrameBuffer *game = compositor->Layer(GameLayer);
+	FrameBuffer *overlay = compositor->Layer(OverlayLayer);
+	ColorStage *color = new ColorStage(tiles, width, height, DISPLAY_GAMMA, CHANNEL_MICROAMPS, POWER_BUDGET_MA);
+	color->SetBrightness(DISPLAY_BRIGHTNESS);
+	color->SetColorTemperature(DISPLAY_KELVIN);
+	color->SetDitherBits(DITHER_PWM_BITS);
+	PowerGovernor *governor = new PowerGovernor(color, width, height, IDLE_AFTER_SECONDS, IDLE_BRIGHTNESS, IDLE_CHANGE_PERCENT);
 	Menu *m = new Menu();
 	Tetris *t  = new Tetris();
-	InitPlasma();
+	// Displays smaller than the board get no Tetris
+	m->SetOptionShown(TetrisMenuOption, Tetris::FitsFrame(width, height));
+	Plasma *plasma = new Plasma(tiles, width, height);
+	Life *life = new Life(width, height);
+	ParticleSystem *particles = new ParticleSystem(width, height, PARTICLE_CAPACITY);
+	Fireworks *fireworks = new Fireworks(particles);
+	Waterfall *waterfall = new Waterfall(width, height);
+	// Sound for the waterfall, it is hidden from the menu without a device
+	SpectrumFeed *spectrum = new SpectrumFeed(waterfall, interrupt_received);
+	m->SetOptionShown(WaterfallMenuOption, spectrum->IsOpen());
+	t->SetParticles(particles);
+	FrameBudget *budget = new FrameBudget(IDLE_SLEEP_US * QUALITY_BUDGET_PERCENT / 100, QUALITY_RAISE_PERCENT);
 
 	// Enabel KB mode if specified  by cmdline arg
 	isKB = false;
 	if (argc > 1 && isatty(STDIN_FILENO))
 	{
 		std::string kb ("kb");
-		if (kb.compare(argv[1]) == 0)
+		if (kb.compare(argv[1]) == 0 || isTerminal)
 		{
 			std::cout << "KB mode enabled!" << std::endl;
 			isKB = true;
@@ -433,11 +386,60 @@ int main(int argc, char *argv[])
 		}
 	}
 
+	// Record presented frames if a file is given with record=<path>, play
+	// an animation pack given with pack=<path> from the menu and scroll the
+	// text given with ticker=<text>
+	FrameRecorder *recorder = NULL;
+	AnimationPlayer *player = new AnimationPlayer();
+	for (int i = 1; i < argc; i++)
+	{
+		std::string record ("record=");
+		std::string pack ("pack=");
+		std::string ticker ("ticker=");
+		std::string arg (argv[i]);
+		if (arg.compare(0, record.size(), record) == 0)
+		{
+			recorder = new FrameRecorder(arg.c_str() + record.size(), width, height, RECORD_KEYFRAME_INTERVAL);
+		}
+		else if (arg.compare(0, pack.size(), pack) == 0)
+		{
+			player->Open(arg.c_str() + pack.size(), width, height);
+			m->SetOptionShown(PlayerMenuOption, player->IsOpen());
+		}
+		else if (arg.compare(0, ticker.size(), ticker) == 0 && arg.size() > ticker.size())
+		{
+			m->SetTickerText(argv[i] + ticker.size());
+		}
+	}
+
 	_running = true;
+	MatrixMode drawnMode = matrixMode;
+	bool isGamePaused = false;
+
+	// Frames are colored and presented on their own thread, while the
+	// next one is rendered here
+	FramePipeline *pipeline = new FramePipeline(width, height, [&](const FrameBuffer *frame, unsigned framerateFraction) {
+		if (preview != NULL)
+		{
+			// The terminal applies its own gamma, it gets the composed
+			// frame. Without vsync the frame period is slept instead.
+			preview->Present(frame);
+			usleep(1000000 * framerateFraction / REFRESH_RATE_HZ);
+		}
+		else
+		{
+			pool->Present(color->Apply(frame), framerateFraction);
+		}
+	});
 
 	// Game Engine
 	while (!interrupt_received && _running)
 	{
+		// Input is read once the last frame is presenting, the frame made
+		// from it is next in line
+		pipeline->WaitForSlot();
+		budget->Begin();
+
 		if (isKB)
 		{
 			if (inputAvailable())
@@ -445,15 +447,57 @@ int main(int argc, char *argv[])
 				getch();
 			}
 		}
-		else
+		else if (!isTerminal)
 		{
 			getArcadeInput();
 		}
 
+		// Tetris, the ticker and playback run on time, they can't be slowed
+		// down. Waking up redraws the frame at full brightness.
+		if (governor->Update(hasInput() || matrixMode == TetrisMode || matrixMode == TickerMode || matrixMode == PlaybackMode || matrixMode == FireworksMode || matrixMode == WaterfallMode))
+		{
+			compositor->Output()->MarkDirty();
+		}
+
+		// A menu left alone turns into the screensaver until a button is
+		// pressed
+		if (matrixMode == MenuMode && governor->IsIdle())
+		{
+			life->Seed();
+			matrixMode = LifeMode;
+		}
+
+		// Every mode but Tetris draws its whole screen on the overlay, and Tetris
+		// its sparks, switching between them has to redraw all of it
+		if (matrixMode != drawnMode)
+		{
+			if (matrixMode == MenuMode || matrixMode == ClockMode || matrixMode == TickerMode)
+			{
+				m->InvalidateCanvas();
+			}
+			else if (matrixMode == PlaybackMode)
+			{
+				player->InvalidateCanvas();
+			}
+			else if (matrixMode == TetrisMode)
+			{
+				particles->InvalidateCanvas();
+			}
+			else if (matrixMode == FireworksMode)
+			{
+				fireworks->InvalidateCanvas();
+			}
+			else if (matrixMode == WaterfallMode)
+			{
+				waterfall->InvalidateCanvas();
+			}
+			drawnMode = matrixMode;
+		}
+
 		switch (matrixMode)
 		{
 			case MenuMode:
-				switch (m->Loop(matrix, inputs))
+				switch (m->Loop(overlay, inputs))
 				{
 					case TetrisMenuOption:
 						matrixMode = TetrisMode;
@@ -464,8 +508,24 @@ int main(int argc, char *argv[])
 					case ClockMenuOption:
 						matrixMode = ClockMode;
 						break;
+					case TickerMenuOption:
+						matrixMode = TickerMode;
+						break;
+					case PlayerMenuOption:
+						matrixMode = PlaybackMode;
+						break;
+					case FireworksMenuOption:
+						matrixMode = FireworksMode;
+						break;
+					case WaterfallMenuOption:
+						matrixMode = WaterfallMode;
+						break;
 					case RotateMenuOption:
-						matrix->ApplyPixelMapper(FindPixelMapper("Rotate", 4, 1, "90"));
+						if (pool != NULL)
+						{
+							pool->Rotate();
+						}
+						compositor->Output()->MarkDirty();
 						break;
 					default:
 						break;
@@ -475,17 +535,52 @@ int main(int argc, char *argv[])
 				if (t->PlayTetris(inputs) == -1)
 				{
 					matrixMode = MenuMode;
+					isGamePaused = true;
 				}
-				t->DrawTetris(matrix);
+				t->DrawTetris(game);
+				particles->Update();
+				particles->Draw(overlay);
 				break;
 			// case AnimationMode:
-			// 	if (PlasmaLoop(matrix, inputs) == -1)
+			// 	if (plasma->Loop(compositor->Layer(BackgroundLayer), inputs) == -1)
 			// 	{
 			// 		matrixMode = MenuMode;
 			// 	}
 			// 	break;
 			case ClockMode:
-				if(m->ClockLoop(matrix, inputs) == -1)
+				if(m->ClockLoop(overlay, inputs) == -1)
+				{
+					matrixMode = MenuMode;
+				}
+				break;
+			case TickerMode:
+				if (m->TickerLoop(overlay, inputs) == -1)
+				{
+					matrixMode = MenuMode;
+				}
+				break;
+			case PlaybackMode:
+				if (player->Loop(overlay, inputs) == -1)
+				{
+					// A corrupt pack is closed, Play goes away with it
+					m->SetOptionShown(PlayerMenuOption, player->IsOpen());
+					matrixMode = MenuMode;
+				}
+				break;
+			case LifeMode:
+				if (life->Loop(overlay, inputs) == -1)
+				{
+					matrixMode = MenuMode;
+				}
+				break;
+			case FireworksMode:
+				if (fireworks->Loop(overlay, inputs) == -1)
+				{
+					matrixMode = MenuMode;
+				}
+				break;
+			case WaterfallMode:
+				if (waterfall->Loop(overlay, inputs) == -1)
 				{
 					matrixMode = MenuMode;
 				}
@@ -493,6 +588,46 @@ int main(int argc, char *argv[])
 			default:
 				break;
 		}
+
+		// Every mode renders into its layer, blend the changed ones and
+		// upload the result in one pass when it changed or dithering has to
+		// move on to its next levels. Otherwise there is nothing to do until
+		// the next input poll.
+		showLayers(compositor, matrixMode, isGamePaused);
+		// The waterfall scrolls by moving where its ring starts
+		compositor->SetRowOffset(OverlayLayer, matrixMode == WaterfallMode ? waterfall->NewestRow() : 0);
+		compositor->Compose();
+		FrameBuffer *frame = compositor->Output();
+		if (frame->IsDirty() || color->IsDithering())
+		{
+			if (frame->IsDirty())
+			{
+				// The screensaver changes all the time, only input ends idle
+				if (matrixMode != LifeMode)
+				{
+					governor->NoteFrame(frame);
+				}
+				if (recorder != NULL)
+				{
+					recorder->Record(frame);
+				}
+				frame->ClearDirty();
+			}
+
+			// Frame time is the rendering, color and upload happen on the
+			// presenting thread
+			if (budget->End())
+			{
+				t->SetQuality(budget->Level());
+				m->SetQuality(budget->Level());
+				plasma->SetQuality(budget->Level());
+			}
+			pipeline->Submit(frame, governor->IsIdle() ? IDLE_FRAMERATE_FRACTION : FRAMERATE_FRACTION);
+		}
+		else
+		{
+			usleep(governor->IsIdle() ? IDLE_POLL_US : IDLE_SLEEP_US);
+		}
 	}
 
 	interrupt_received = true;
@@ -502,6 +637,23 @@ int main(int argc, char *argv[])
 		disableTerminalInput();
 	}
 
+	delete pipeline;
+	delete player;
+	delete recorder;
+	delete spectrum;
+	delete waterfall;
+	delete fireworks;
+	delete particles;
+	delete life;
+	delete plasma;
+	delete budget;
+	delete governor;
+	delete color;
+	delete compositor;
+	delete exporter;
+	delete tiles;
+	delete preview;
+	delete pool;
 	delete matrix;
 
 	return 0;
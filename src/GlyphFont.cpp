@@ -0,0 +1,61 @@
+#include "GlyphFont.h"
+
+using namespace rgb_matrix;
+
+// Draw one glyph with its baseline at y, returns how far to advance
+int DrawGlyph(FrameBuffer *frame, const GlyphFont &font, int x, int y, const Color &color, const Color *bgColor, char c)
+{
+    unsigned char code = c;
+    if (code < GLYPH_FIRST || code > GLYPH_LAST)
+    {
+        return 0;
+    }
+
+    const Glyph &g = font.glyphs[code - GLYPH_FIRST];
+    Pixel fg = MakePixel(color.r, color.g, color.b);
+    Pixel bg = bgColor != NULL ? MakePixel(bgColor->r, bgColor->g, bgColor->b) : fg;
+
+    int top = y - g.height - g.yOffset;
+    for (int row = 0; row < g.height; row++)
+    {
+        int py = top + row;
+        if (py < 0 || py >= frame->height())
+        {
+            continue;
+        }
+
+        Pixel *line = frame->Row(py);
+        uint32_t bits = font.rows[g.firstRow + row];
+        for (int col = 0; col < g.width; col++, bits <<= 1)
+        {
+            int px = x + col;
+            if (px < 0 || px >= frame->width())
+            {
+                continue;
+            }
+
+            if (bits & 0x80000000)
+            {
+                line[px] = fg;
+            }
+            else if (bgColor != NULL)
+            {
+                line[px] = bg;
+            }
+        }
+    }
+
+    return g.width;
+}
+
+// Draw text with its baseline at y, returns the drawn width
+int DrawGlyphText(FrameBuffer *frame, const GlyphFont &font, int x, int y, const Color &color, const Color *bgColor, const char *text, int spacing)
+{
+    int start = x;
+    for (; *text; text++)
+    {
+        x += DrawGlyph(frame, font, x, y, color, bgColor, *text);
+        x += spacing;
+    }
+    return x - start;
+}
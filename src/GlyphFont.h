@@ -0,0 +1,39 @@
+#ifndef _glyphfont
+#define _glyphfont
+
+#include "FrameBuffer.h"
+
+#include "graphics.h"
+
+#include <stdint.h>
+
+// Printable ASCII, the only text the modes draw
+#define GLYPH_FIRST 32
+#define GLYPH_LAST 126
+#define GLYPH_COUNT (GLYPH_LAST - GLYPH_FIRST + 1)
+
+using namespace rgb_matrix;
+
+// Pre-rasterized BDF glyph, drawn like the library draws BDF glyphs
+struct Glyph
+{
+    uint8_t width; // Advance, also how many columns are drawn
+    uint8_t height;
+    int8_t yOffset;
+    uint16_t firstRow;
+};
+
+// Font with one bitmap row per glyph line, leftmost pixel in bit 31.
+// Generated from the BDF files at build time, see FontGen.cpp.
+struct GlyphFont
+{
+    int height;
+    int baseline;
+    const Glyph *glyphs;
+    const uint32_t *rows;
+};
+
+int DrawGlyph(FrameBuffer *frame, const GlyphFont &font, int x, int y, const Color &color, const Color *bgColor, char c);
+int DrawGlyphText(FrameBuffer *frame, const GlyphFont &font, int x, int y, const Color &color, const Color *bgColor, const char *text, int spacing);
+
+#endif
@@ -0,0 +1,212 @@
+#include "Life.h"
+
+#include <algorithm>
+#include <time.h>
+
+using namespace rgb_matrix;
+
+#define LIVE_COLOR MakePixel(210, 255, 190)
+
+Life::Life(int width, int height)
+{
+    this->width = width;
+    this->height = height;
+    wordsPerRow = (width + 63) / 64;
+    tailMask = width % 64 == 0 ? ~0ULL : (1ULL << (width % 64)) - 1;
+
+    for (int i = 0; i < LIFE_HISTORY; i++)
+    {
+        generations[i].resize(wordsPerRow * height);
+    }
+    for (int i = 0; i < 6; i++)
+    {
+        shifted[i].resize(wordsPerRow);
+    }
+    randomState = (uint64_t)time(0) * 0x9E3779B97F4A7C15ULL | 1;
+
+    // Colors by history, bit n set when the cell lived n generations ago.
+    // The most recent generation it lived decides how far it has faded.
+    trailColors[0] = MakePixel(0, 0, 0);
+    for (int h = 1; h < (1 << LIFE_HISTORY); h++)
+    {
+        int age = __builtin_ctz(h);
+        trailColors[h] = age == 0 ? LIVE_COLOR : MakePixel(0, 150 >> age, 255 >> (age - 1));
+    }
+
+    Seed();
+
+    // Prevent a button getting immediately handled
+    for (int i = 0; i < TOTAL_INPUTS; i++)
+    {
+        prevInputs[i] = true;
+    }
+}
+
+// xorshift64*
+uint64_t Life::random()
+{
+    randomState ^= randomState >> 12;
+    randomState ^= randomState << 25;
+    randomState ^= randomState >> 27;
+    return randomState * 0x2545F4914F6CDD1DULL;
+}
+
+// Fresh random grid, about three in eight cells alive, and no history
+void Life::Seed()
+{
+    for (int i = 0; i < LIFE_HISTORY; i++)
+    {
+        std::fill(generations[i].begin(), generations[i].end(), 0);
+    }
+    newest = 0;
+    generationCount = 0;
+
+    uint64_t *grid = &generations[newest][0];
+    for (int y = 0; y < height; y++)
+    {
+        for (int i = 0; i < wordsPerRow; i++)
+        {
+            uint64_t cells = random() & (random() | random());
+            grid[y * wordsPerRow + i] = i == wordsPerRow - 1 ? cells & tailMask : cells;
+        }
+    }
+}
+
+// Every cell's west and east neighbour moved into its bit, wrapping around
+// the row. Bit x of a word is column x, so west is a shift up.
+void Life::shiftRow(const uint64_t *row, uint64_t *west, uint64_t *east) const
+{
+    int last = wordsPerRow - 1;
+    int lastBit = (width - 1) % 64;
+    for (int i = 0; i < wordsPerRow; i++)
+    {
+        uint64_t before = i > 0 ? row[i - 1] >> 63 : (row[last] >> lastBit) & 1;
+        uint64_t after = i < last ? row[i + 1] << 63 : 0;
+        west[i] = (row[i] << 1) | before;
+        east[i] = (row[i] >> 1) | after;
+    }
+    east[last] = (east[last] & ~(1ULL << lastBit)) | ((row[0] & 1) << lastBit);
+    west[last] &= tailMask;
+}
+
+static inline void fullAdd(uint64_t a, uint64_t b, uint64_t c, uint64_t *sum, uint64_t *carry)
+{
+    uint64_t t = a ^ b;
+    *sum = t ^ c;
+    *carry = (a & b) | (t & c);
+}
+
+// Neighbour counts as bit sliced sums: ones, and the twos carried out of
+// them summed again into twos and fours. A cell lives on with exactly two
+// or three neighbours, it is born with three.
+void Life::stepRow(const uint64_t *above, const uint64_t *row, const uint64_t *below, uint64_t *next)
+{
+    uint64_t *aboveWest = &shifted[0][0], *aboveEast = &shifted[1][0];
+    uint64_t *rowWest = &shifted[2][0], *rowEast = &shifted[3][0];
+    uint64_t *belowWest = &shifted[4][0], *belowEast = &shifted[5][0];
+    shiftRow(above, aboveWest, aboveEast);
+    shiftRow(row, rowWest, rowEast);
+    shiftRow(below, belowWest, belowEast);
+
+    for (int i = 0; i < wordsPerRow; i++)
+    {
+        uint64_t aboveOnes, aboveTwos, belowOnes, belowTwos, ones, onesTwos;
+        fullAdd(aboveWest[i], above[i], aboveEast[i], &aboveOnes, &aboveTwos);
+        fullAdd(belowWest[i], below[i], belowEast[i], &belowOnes, &belowTwos);
+        uint64_t rowOnes = rowWest[i] ^ rowEast[i];
+        uint64_t rowTwos = rowWest[i] & rowEast[i];
+        fullAdd(aboveOnes, belowOnes, rowOnes, &ones, &onesTwos);
+
+        uint64_t twos, fours;
+        fullAdd(aboveTwos, belowTwos, rowTwos, &twos, &fours);
+        fours |= twos & onesTwos;
+        twos ^= onesTwos;
+
+        next[i] = twos & ~fours & (ones | row[i]);
+    }
+}
+
+void Life::Step()
+{
+    const uint64_t *grid = &generations[newest][0];
+    newest = (newest + 1) % LIFE_HISTORY;
+    uint64_t *next = &generations[newest][0];
+
+    for (int y = 0; y < height; y++)
+    {
+        const uint64_t *above = grid + ((y + height - 1) % height) * wordsPerRow;
+        const uint64_t *below = grid + ((y + 1) % height) * wordsPerRow;
+        stepRow(above, grid + y * wordsPerRow, below, next + y * wordsPerRow);
+    }
+    generationCount++;
+}
+
+// Dead, still or blinking with period two
+bool Life::isStale() const
+{
+    const std::vector<uint64_t> &now = generations[newest];
+    const std::vector<uint64_t> &before = generations[(newest + LIFE_HISTORY - 2) % LIFE_HISTORY];
+    return generationCount >= LIFE_MAX_GENERATIONS || (generationCount >= 2 && now == before);
+}
+
+void Life::draw(FrameBuffer *frame) const
+{
+    const uint64_t *history[LIFE_HISTORY];
+    for (int k = 0; k < LIFE_HISTORY; k++)
+    {
+        history[k] = &generations[(newest + LIFE_HISTORY - k) % LIFE_HISTORY][0];
+    }
+
+    for (int y = 0; y < height; y++)
+    {
+        Pixel *row = frame->Row(y);
+        for (int i = 0; i < wordsPerRow; i++)
+        {
+            uint64_t words[LIFE_HISTORY];
+            for (int k = 0; k < LIFE_HISTORY; k++)
+            {
+                words[k] = history[k][y * wordsPerRow + i];
+            }
+
+            int columns = i == wordsPerRow - 1 ? width - 64 * i : 64;
+            for (int bit = 0; bit < columns; bit++)
+            {
+                int h = 0;
+                for (int k = 0; k < LIFE_HISTORY; k++)
+                {
+                    h |= ((words[k] >> bit) & 1) << k;
+                }
+                row[64 * i + bit] = trailColors[h];
+            }
+        }
+    }
+}
+
+int Life::Loop(FrameBuffer *frame, volatile bool *inputs)
+{
+    // Any button ends the screensaver
+    bool isPressed = false;
+    for (int i = 0; i < TOTAL_INPUTS; i++)
+    {
+        isPressed |= inputs[i] && !prevInputs[i];
+        prevInputs[i] = inputs[i];
+        inputs[i] = false;
+    }
+    if (isPressed)
+    {
+        return -1;
+    }
+
+    if (isStale())
+    {
+        Seed();
+    }
+    else
+    {
+        Step();
+    }
+    draw(frame);
+    frame->MarkDirty();
+
+    return 0;
+}
@@ -0,0 +1,57 @@
+#ifndef _life
+#define _life
+
+#include "Inputs.h"
+#include "FrameBuffer.h"
+
+#include <stdint.h>
+#include <vector>
+
+// Generations kept for the trails, one bit of each per cell
+#define LIFE_HISTORY 8
+// Generations before a new random grid, long lived oscillators and
+// gliders would otherwise run forever
+#define LIFE_MAX_GENERATIONS 3000
+
+using namespace rgb_matrix;
+
+// Conway's Game of Life on a grid wrapping at the frame edges.
+// Every row is packed into 64-bit words, a 64 wide display is one word per
+// row and wider ones take more. A generation counts the eight neighbours
+// of all cells of a word at once with bitwise adders, there is no per cell
+// work or branching. Cells that died leave a trail fading over the last
+// generations.
+class Life
+{
+    private:
+        int width;
+        int height;
+        int wordsPerRow;
+        // Bits of the last word past the width
+        uint64_t tailMask;
+
+        // Ring of the last generations, newest at newest
+        std::vector<uint64_t> generations[LIFE_HISTORY];
+        int newest;
+        int generationCount;
+        // West and east neighbours of the rows above, at and below a row
+        std::vector<uint64_t> shifted[6];
+        uint64_t randomState;
+
+        Pixel trailColors[1 << LIFE_HISTORY];
+        bool prevInputs[TOTAL_INPUTS];
+
+        uint64_t random();
+        void shiftRow(const uint64_t *row, uint64_t *west, uint64_t *east) const;
+        void stepRow(const uint64_t *above, const uint64_t *row, const uint64_t *below, uint64_t *next);
+        bool isStale() const;
+        void draw(FrameBuffer *frame) const;
+    public:
+        Life(int width, int height);
+
+        void Seed();
+        void Step();
+        int Loop(FrameBuffer *frame, volatile bool *inputs);
+};
+
+#endif
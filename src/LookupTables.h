@@ -0,0 +1,43 @@
+#ifndef _lookuptables
+#define _lookuptables
+
+#include <math.h>
+#include <stdint.h>
+
+// Fixed point trig: a turn is TRIG_STEPS angle steps, results are scaled
+// by TRIG_ONE
+#define TRIG_BITS 10
+#define TRIG_STEPS (1 << TRIG_BITS)
+#define TRIG_MASK (TRIG_STEPS - 1)
+#define TRIG_SHIFT 14
+#define TRIG_ONE (1 << TRIG_SHIFT)
+
+// Plasma height maps baked for one panel size, twice the frame in both
+// directions. Generated at build time, see TableGen.cpp.
+struct PlasmaMaps
+{
+    int width;
+    int height;
+    const uint8_t *heights1;
+    const uint8_t *heights2;
+};
+
+// Heights of both plasma maps at x, y. Concentric ripples and two stretched
+// waves centered on the map, the first peaks at 128 and the second at 127
+// so their sum fits a byte.
+inline void PlasmaHeights(int mapWidth, int mapHeight, int x, int y, uint8_t *height1, uint8_t *height2)
+{
+    double size = mapWidth > mapHeight ? mapWidth : mapHeight;
+    double stretch = (3 * M_PI) / (size / 4);
+    double cx = x - mapWidth / 2;
+    double cy = y - mapHeight / 2;
+
+    double ripple = sin(sqrt(cx * cx + cy * cy) * stretch);
+    *height1 = (uint8_t)floor((ripple + 1) / 2 * 128);
+
+    double d1 = sqrt(0.64 * cx * cx + 1.69 * cy * cy) * 0.022;
+    double d2 = sqrt(1.8225 * cx * cx + 0.2025 * cy * cy) * 0.022;
+    *height2 = (uint8_t)floor((sin(d1) + sin(d2) + 2) / 4 * 127);
+}
+
+#endif
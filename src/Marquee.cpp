@@ -0,0 +1,102 @@
+#include "Marquee.h"
+
+#include <stddef.h>
+#include <string.h>
+
+using namespace rgb_matrix;
+
+Marquee::Marquee()
+{
+    strip = NULL;
+    position = 0;
+}
+
+Marquee::~Marquee()
+{
+    delete strip;
+}
+
+// Rasterize the text once on black, followed by a gap before it repeats
+void Marquee::SetText(const GlyphFont &font, const Color &color, const char *text, int gap)
+{
+    int width = 0;
+    for (const char *c = text; *c; c++)
+    {
+        unsigned char code = *c;
+        if (code >= GLYPH_FIRST && code <= GLYPH_LAST)
+        {
+            width += font.glyphs[code - GLYPH_FIRST].width;
+        }
+    }
+
+    delete strip;
+    strip = new FrameBuffer(width + gap, font.height);
+    strip->Fill(0, 0, 0);
+    DrawGlyphText(strip, font, 0, font.baseline, color, NULL, text, 0);
+    position = 0;
+}
+
+// Move the text left, step is in sub-pixels and may be negative
+void Marquee::Advance(int step)
+{
+    if (strip == NULL)
+    {
+        return;
+    }
+
+    int length = strip->width() << MARQUEE_SUBPIXEL_BITS;
+    position = (position + step) % length;
+    if (position < 0)
+    {
+        position += length;
+    }
+}
+
+// Copy the window at the current position into the rows from y down,
+// every column blended with the next one by the sub-pixel fraction.
+// Without sub-pixels the window snaps to whole pixels and is copied as is.
+void Marquee::Draw(FrameBuffer *frame, int y, bool isSubpixel)
+{
+    if (strip == NULL)
+    {
+        return;
+    }
+
+    int stripWidth = strip->width();
+    int start = position >> MARQUEE_SUBPIXEL_BITS;
+    uint16_t next = isSubpixel ? position & ((1 << MARQUEE_SUBPIXEL_BITS) - 1) : 0;
+    uint16_t current = (1 << MARQUEE_SUBPIXEL_BITS) - next;
+
+    for (int row = 0; row < strip->height(); row++)
+    {
+        int py = y + row;
+        if (py < 0 || py >= frame->height())
+        {
+            continue;
+        }
+
+        const Pixel *src = strip->Row(row);
+        Pixel *dst = frame->Row(py);
+        if (next == 0)
+        {
+            // The strip is at least a display wide, so the window wraps once
+            int first = stripWidth - start < frame->width() ? stripWidth - start : frame->width();
+            memcpy(dst, src + start, sizeof(Pixel) * first);
+            memcpy(dst + first, src, sizeof(Pixel) * (frame->width() - first));
+            continue;
+        }
+
+        int col = start;
+        for (int x = 0; x < frame->width(); x++)
+        {
+            int following = col + 1 == stripWidth ? 0 : col + 1;
+            const Pixel &p = src[col];
+            const Pixel &q = src[following];
+            dst[x].r = (p.r * current + q.r * next) >> MARQUEE_SUBPIXEL_BITS;
+            dst[x].g = (p.g * current + q.g * next) >> MARQUEE_SUBPIXEL_BITS;
+            dst[x].b = (p.b * current + q.b * next) >> MARQUEE_SUBPIXEL_BITS;
+            dst[x].a = (p.a * current + q.a * next) >> MARQUEE_SUBPIXEL_BITS;
+            col = following;
+        }
+    }
+}
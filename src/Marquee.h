@@ -0,0 +1,36 @@
+#ifndef _marquee
+#define _marquee
+
+#include "FrameBuffer.h"
+#include "GlyphFont.h"
+
+#include "graphics.h"
+
+// Scroll position fraction bits, positions and speeds are in 1/256 pixels
+#define MARQUEE_SUBPIXEL_BITS 8
+
+using namespace rgb_matrix;
+
+// Scrolling text drawn once into a strip as wide as the text plus a gap.
+// Each frame copies a display wide window out of the strip, blending
+// neighbouring columns for sub-pixel positions, so a frame costs the same
+// however long the text is.
+class Marquee
+{
+    private:
+        FrameBuffer *strip;
+        int position;
+
+    public:
+        Marquee();
+        ~Marquee();
+
+        void SetText(const GlyphFont &font, const Color &color, const char *text, int gap);
+        inline bool HasText() const { return strip != NULL; }
+        inline int Height() const { return strip != NULL ? strip->height() : 0; }
+
+        void Advance(int step);
+        void Draw(FrameBuffer *frame, int y, bool isSubpixel);
+};
+
+#endif
@@ -1,5 +1,6 @@
 #include "Menu.h"
 #include "Inputs.h"
+#include "Fonts.h"
 
 #include "led-matrix.h"
 #include "graphics.h"
@@ -8,22 +9,51 @@
 
 using namespace rgb_matrix;
 
+// Layouts are laid out for 64x64 and centered on bigger displays
+const int layout_size = 64;
 const int x_orig = 11;
 const int y_orig = 10;
-const int y_scale = 12;
+const int y_scale = 10;
 const int x_marker_shift = 6;
 const int y_marker_shift = 3;
 const int marker_radius = 2;
 const int letter_spacing = 0;
+const uint8_t menu_flood_alpha = 192;
+// Ticker speeds in 1/256 pixels per frame
+const int ticker_speed = 128;
+const int ticker_speed_step = 32;
+const int ticker_speed_max = 1024;
 
+static int layoutX(FrameBuffer *frame)
+{
+    return (frame->width() - layout_size) / 2;
+}
+
+static int layoutY(FrameBuffer *frame)
+{
+    return (frame->height() - layout_size) / 2;
+}
+
+// Hidden options are skipped over
 void Menu::upOption()
 {
-    selectedOption = (selectedOption == TetrisMenuOption) ? RotateMenuOption : static_cast<MenuOptions>(static_cast<int>(selectedOption)-1);
+    do
+    {
+        selectedOption = (selectedOption == TetrisMenuOption) ? RotateMenuOption : static_cast<MenuOptions>(static_cast<int>(selectedOption)-1);
+    } while (!isOptionShown(selectedOption));
 }
 
 void Menu::downOption()
 {
-    selectedOption = (selectedOption == RotateMenuOption) ? TetrisMenuOption : static_cast<MenuOptions>(static_cast<int>(selectedOption)+1);
+    do
+    {
+        selectedOption = (selectedOption == RotateMenuOption) ? TetrisMenuOption : static_cast<MenuOptions>(static_cast<int>(selectedOption)+1);
+    } while (!isOptionShown(selectedOption));
+}
+
+bool Menu::isOptionShown(int option)
+{
+    return isShown[option];
 }
 
 Menu::Menu()
@@ -31,17 +61,31 @@ Menu::Menu()
     clockXShift = 0;
     clockYShift = 0;
     isShowSeconds = true;
+    ticker = new Marquee();
+    tickerText = "GameMatrix";
+    tickerSpeed = ticker_speed;
+    isTickerSubpixel = true;
+    for (int i = 0; i < MENU_OPTIONS_COUNT; i++)
+    {
+        isShown[i] = true;
+    }
+    isShown[PlayerMenuOption] = false;
     Reset(); 
+    InvalidateCanvas();
 }
 
 Menu::~Menu()
 {
-
+    delete ticker;
 }
 
 void Menu::Reset()
 {
     selectedOption = TetrisMenuOption;
+    if (!isOptionShown(selectedOption))
+    {
+        downOption();
+    }
 
     // Prevent an option getting immediately returned
     for (int i = 0; i < TOTAL_INPUTS; i++)
@@ -50,7 +94,16 @@ void Menu::Reset()
     }
 }
 
-int Menu::Loop(RGBMatrix *matrix, volatile bool *inputs)
+// Something else drew on the frame, next loop redraws everything
+void Menu::InvalidateCanvas()
+{
+    drawnOption = -1;
+    drawnTime = 0;
+    drawnText = NULL;
+    isTickerDrawn = false;
+}
+
+int Menu::Loop(FrameBuffer *frame, volatile bool *inputs)
 {
     // Proccess inputs on button down
     if (inputs[UpStick] && !prevInputs[UpStick])
@@ -80,24 +133,42 @@ int Menu::Loop(RGBMatrix *matrix, volatile bool *inputs)
         inputs[i] = false;
     }
 
+    if (selectedOption == drawnOption)
+    {
+        return -1;
+    }
+    drawnOption = selectedOption;
+    frame->MarkDirty();
+
     // Draw Menu
     Color color(255, 255, 0);
     Color bg_color(0, 0, 0);
     Color flood_color(0, 0, 0);
     
-    // Load font
-    rgb_matrix::Font font;
-    if (!font.LoadFont(FONT_FILE_8BIT)) {
-        fprintf(stderr, "Couldn't load font '%s'\n", FONT_FILE_8BIT);
-        return -1;
-    }
+    // Darken whatever is below, like a paused game
+    frame->Fill(MakePixel(flood_color.r, flood_color.g, flood_color.b, menu_flood_alpha));
 
-    // Clean background
-    matrix->Fill(flood_color.r, flood_color.g, flood_color.b);
-
-    // Draw Text
+    // Draw Text, hidden options leave no gap and rows close up when there
+    // are too many for the layout
+    int rows = 0;
     for (int i = 0; i < MENU_OPTIONS_COUNT; i++)
     {
+        rows += isOptionShown(i) ? 1 : 0;
+    }
+    int spacing = rows > 1 && (layout_size - 1 - y_orig) / (rows - 1) < y_scale ? (layout_size - 1 - y_orig) / (rows - 1) : y_scale;
+    int row = 0;
+    int selectedRow = 0;
+    for (int i = 0; i < MENU_OPTIONS_COUNT; i++)
+    {
+        if (!isOptionShown(i))
+        {
+            continue;
+        }
+        if (i == selectedOption)
+        {
+            selectedRow = row;
+        }
+
         const char* text;
         switch (i)
         {
@@ -110,21 +181,34 @@ int Menu::Loop(RGBMatrix *matrix, volatile bool *inputs)
             case ClockMenuOption:
                 text = "Clock";
                 break;
+            case TickerMenuOption:
+                text = "Ticker";
+                break;
+            case PlayerMenuOption:
+                text = "Play";
+                break;
+            case FireworksMenuOption:
+                text = "Sparks";
+                break;
+            case WaterfallMenuOption:
+                text = "Audio";
+                break;
             case RotateMenuOption:
                 text = "Rotate";
                 break;
             default:
                 break;
         }
-        rgb_matrix::DrawText(matrix, font, x_orig, y_orig + i * y_scale, color, &bg_color, text, letter_spacing);
+        DrawGlyphText(frame, font8Bit, layoutX(frame) + x_orig, layoutY(frame) + y_orig + row * spacing, color, &bg_color, text, letter_spacing);
+        row++;
     }
 
-    rgb_matrix::DrawCircle(matrix, x_orig - x_marker_shift, y_orig - y_marker_shift + selectedOption*y_scale, marker_radius, color);
+    rgb_matrix::DrawCircle(frame, layoutX(frame) + x_orig - x_marker_shift, layoutY(frame) + y_orig - y_marker_shift + selectedRow*spacing, marker_radius, color);
 
     return -1;
 }
 
-int Menu::ClockLoop(RGBMatrix *matrix, volatile bool *inputs)
+int Menu::ClockLoop(FrameBuffer *frame, volatile bool *inputs)
 {
     // Proccess inputs on button down
     if (inputs[UpStick] && !prevInputs[UpStick])
@@ -169,37 +253,115 @@ int Menu::ClockLoop(RGBMatrix *matrix, volatile bool *inputs)
         inputs[i] = false;
     }
 
+    // Clock only changes once a second
+    time_t now = time(0);
+    if (now == drawnTime && clockXShift == drawnXShift && clockYShift == drawnYShift && isShowSeconds == drawnShowSeconds)
+    {
+        return 0;
+    }
+    drawnTime = now;
+    drawnXShift = clockXShift;
+    drawnYShift = clockYShift;
+    drawnShowSeconds = isShowSeconds;
+    frame->MarkDirty();
+
     Color color(150, 150, 150);
     Color bg_color(0, 0, 0);
-    Color flood_color(0, 0, 0);
-    
-    // Load font
-    rgb_matrix::Font font;
-    if (!font.LoadFont(FONT_FILE_CLOCK)) {
-        fprintf(stderr, "Couldn't load font '%s'\n", FONT_FILE_CLOCK);
-        return -1;
-    }
 
-    // Clean background
-    matrix->Fill(flood_color.r, flood_color.g, flood_color.b);
+    // Transparent background, the clock can sit on top of other layers
+    frame->Clear();
 
-    time_t now = time(0);
     tm *ltm = localtime(&now);
 
     // Draw Text
     char buf[10];
     strftime(buf, 10, "%I:%M", ltm);
-    rgb_matrix::DrawText(matrix, font, 10 + clockXShift, 29 + clockYShift, color, &bg_color, buf, letter_spacing);
+    DrawGlyphText(frame, fontClock, layoutX(frame) + 10 + clockXShift, layoutY(frame) + 29 + clockYShift, color, &bg_color, buf, letter_spacing);
     if (isShowSeconds)
     {
         strftime(buf, 10, "%S", ltm);
-        rgb_matrix::DrawText(matrix, font, 24 + clockXShift, 45 + clockYShift, color, &bg_color, buf, letter_spacing);
+        DrawGlyphText(frame, fontClock, layoutX(frame) + 24 + clockXShift, layoutY(frame) + 45 + clockYShift, color, &bg_color, buf, letter_spacing);
     }
 
     return 0;
 }
 
-int Menu::TestLoop(RGBMatrix *matrix, volatile bool *inputs, const char* text)
+// Only the ticker has work to shed, it snaps to whole pixels
+void Menu::SetQuality(int level)
+{
+    isTickerSubpixel = level > 0;
+}
+
+// Options that can't be used are hidden, like Play before a pack is open
+void Menu::SetOptionShown(int option, bool shown)
+{
+    isShown[option] = shown;
+    if (!isOptionShown(selectedOption))
+    {
+        downOption();
+    }
+    InvalidateCanvas();
+}
+
+// Text is only rasterized again the next time the ticker is drawn
+void Menu::SetTickerText(const char* text)
+{
+    tickerText = text;
+    delete ticker;
+    ticker = new Marquee();
+}
+
+int Menu::TickerLoop(FrameBuffer *frame, volatile bool *inputs)
+{
+    // Proccess inputs on button down
+    if (inputs[UpStick] && !prevInputs[UpStick] && tickerSpeed < ticker_speed_max)
+    {
+        tickerSpeed += ticker_speed_step;
+    }
+
+    if (inputs[DownStick] && !prevInputs[DownStick] && tickerSpeed > ticker_speed_step)
+    {
+        tickerSpeed -= ticker_speed_step;
+    }
+
+    if (inputs[MenuButton] && !prevInputs[MenuButton])
+    {
+        for (int i = 0; i < TOTAL_INPUTS; i++)
+        {
+            prevInputs[i] = inputs[i];
+            inputs[i] = false;
+        }
+
+        return -1;
+    }
+
+    for (int i = 0; i < TOTAL_INPUTS; i++)
+    {
+        prevInputs[i] = inputs[i];
+        inputs[i] = false;
+    }
+
+    if (!ticker->HasText())
+    {
+        Color color(255, 255, 0);
+        ticker->SetText(fontClock, color, tickerText, frame->width());
+    }
+
+    // Only the ticker rows change after the first frame
+    if (!isTickerDrawn)
+    {
+        frame->Clear();
+        isTickerDrawn = true;
+    }
+
+    ticker->Advance(tickerSpeed);
+    ticker->Draw(frame, (frame->height() - ticker->Height()) / 2, isTickerSubpixel);
+    frame->MarkDirty();
+
+    return 0;
+}
+
+int Menu::TestLoop(FrameBuffer *frame, volatile bool *inputs, const char* text)
 {
      // Proccess inputs on button down
     if (inputs[MenuButton] && !prevInputs[MenuButton])
@@ -213,23 +375,23 @@ int Menu::TestLoop(RGBMatrix *matrix, volatile bool *inputs, const char* text)
         inputs[i] = false;
     }
 
+    if (text == drawnText)
+    {
+        return 0;
+    }
+    drawnText = text;
+    frame->MarkDirty();
+
     // Draw Menu
     Color color(255, 255, 0);
     Color bg_color(0, 0, 0);
     Color flood_color(0, 0, 0);
     
-    // Load font
-    rgb_matrix::Font font;
-    if (!font.LoadFont(FONT_FILE_8BIT)) {
-        fprintf(stderr, "Couldn't load font '%s'\n", FONT_FILE_8BIT);
-        return -1;
-    }
-
     // Clean background
-    matrix->Fill(flood_color.r, flood_color.g, flood_color.b);
+    frame->Fill(flood_color.r, flood_color.g, flood_color.b);
 
     // Draw Text
-    rgb_matrix::DrawText(matrix, font, x_orig, y_orig , color, &bg_color, text, letter_spacing);
+    DrawGlyphText(frame, font8Bit, layoutX(frame) + x_orig, layoutY(frame) + y_orig, color, &bg_color, text, letter_spacing);
 
     return 0;
 }
\ No newline at end of file
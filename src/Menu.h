@@ -2,18 +2,24 @@
 #define _menu
 
 #include "Inputs.h"
+#include "FrameBuffer.h"
+#include "Marquee.h"
 
 #include "led-matrix.h"
 
-#define FONT_FILE_8BIT "/usr/font/8bit.bdf"
-#define FONT_FILE_CLOCK "/usr/font/9x18.bdf"
-#define MENU_OPTIONS_COUNT 3
+#include <ctime>
+
+#define MENU_OPTIONS_COUNT 7
 
 enum MenuOptions
 {
     TetrisMenuOption,
     //AnimationMenuOption,
     ClockMenuOption,
+    TickerMenuOption,
+    PlayerMenuOption,
+    FireworksMenuOption,
+    WaterfallMenuOption,
     RotateMenuOption
 };
 
@@ -28,15 +34,36 @@ class Menu
         bool prevInputs[TOTAL_INPUTS];
         void upOption();
         void downOption();
+        bool isOptionShown(int option);
+        bool isShown[MENU_OPTIONS_COUNT];
         bool isShowSeconds;
         int clockXShift;
         int clockYShift;
+
+        Marquee *ticker;
+        const char* tickerText;
+        int tickerSpeed;
+        bool isTickerSubpixel;
+
+        // What the frame currently shows, only redraw when it changes
+        int drawnOption;
+        time_t drawnTime;
+        int drawnXShift;
+        int drawnYShift;
+        bool drawnShowSeconds;
+        const char* drawnText;
+        bool isTickerDrawn;
     public:
         Menu();
         ~Menu();
 
         void Reset();
-        int Loop(RGBMatrix *matrix, volatile bool *inputs);
-        int ClockLoop(RGBMatrix *matrix, volatile bool *inputs);
-        int TestLoop(RGBMatrix *matrix, volatile bool *inputs, const char* text);
+        void InvalidateCanvas();
+        int Loop(FrameBuffer *frame, volatile bool *inputs);
+        int ClockLoop(FrameBuffer *frame, volatile bool *inputs);
+        void SetTickerText(const char* text);
+        void SetOptionShown(int option, bool shown);
+        void SetQuality(int level);
+        int TickerLoop(FrameBuffer *frame, volatile bool *inputs);
+        int TestLoop(FrameBuffer *frame, volatile bool *inputs, const char* text);
 };
@@ -0,0 +1,135 @@
+// Host tool turning a recording into an animation pack.
+// Usage: PackGen <recording> <pack> [<frame ms>]
+// Frames last until the next recorded one, the last frame lasts <frame ms>
+// (default 33).
+
+#include "AnimationPlayer.h"
+#include "FrameRecorder.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#define DEFAULT_LAST_FRAME_MS 33
+
+struct PackFrame
+{
+    uint8_t type;
+    uint64_t timestampUs;
+    std::vector<uint8_t> payload;
+};
+
+static bool readRecording(const char *path, uint32_t *width, uint32_t *height, std::vector<PackFrame> *frames)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == NULL)
+    {
+        fprintf(stderr, "Couldn't open recording '%s'\n", path);
+        return false;
+    }
+
+    uint32_t header[4];
+    if (fread(header, sizeof(header), 1, f) != 1 || header[0] != RECORDER_MAGIC || header[1] != RECORDER_VERSION)
+    {
+        fprintf(stderr, "'%s' is not a recording\n", path);
+        fclose(f);
+        return false;
+    }
+    *width = header[2];
+    *height = header[3];
+
+    PackFrame frame;
+    uint32_t length;
+    while (fread(&frame.type, sizeof(frame.type), 1, f) == 1 &&
+           fread(&frame.timestampUs, sizeof(frame.timestampUs), 1, f) == 1 &&
+           fread(&length, sizeof(length), 1, f) == 1)
+    {
+        frame.payload.resize(length);
+        if (length > 0 && fread(&frame.payload[0], 1, length, f) != length)
+        {
+            // A recording cut short ends with a partial frame
+            break;
+        }
+        frames->push_back(frame);
+    }
+    fclose(f);
+
+    // Playback loops back to the first frame, it has to stand on its own
+    while (!frames->empty() && frames->front().type != KeyRecord)
+    {
+        frames->erase(frames->begin());
+    }
+    if (frames->empty())
+    {
+        fprintf(stderr, "'%s' has no keyframe\n", path);
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 3)
+    {
+        fprintf(stderr, "Usage: %s <recording> <pack> [<frame ms>]\n", argv[0]);
+        return 1;
+    }
+    uint32_t lastDurationUs = (argc > 3 ? atoi(argv[3]) : DEFAULT_LAST_FRAME_MS) * 1000;
+
+    uint32_t width, height;
+    std::vector<PackFrame> frames;
+    if (!readRecording(argv[1], &width, &height, &frames))
+    {
+        return 1;
+    }
+
+    FILE *out = fopen(argv[2], "wb");
+    if (out == NULL)
+    {
+        fprintf(stderr, "Couldn't create '%s'\n", argv[2]);
+        return 1;
+    }
+
+    AnimationPackHeader header = {};
+    header.magic = ANIMATION_PACK_MAGIC;
+    header.version = ANIMATION_PACK_VERSION;
+    header.width = width;
+    header.height = height;
+    header.frameCount = frames.size();
+    fwrite(&header, sizeof(header), 1, out);
+
+    std::vector<AnimationPackEntry> index(frames.size());
+    uint64_t offset = sizeof(header);
+    for (size_t i = 0; i < frames.size(); i++)
+    {
+        AnimationPackEntry &e = index[i];
+        e = AnimationPackEntry();
+        e.offset = offset;
+        e.length = frames[i].payload.size();
+        e.durationUs = i + 1 < frames.size() ? frames[i + 1].timestampUs - frames[i].timestampUs : lastDurationUs;
+        e.type = frames[i].type;
+        if (e.length > 0)
+        {
+            fwrite(&frames[i].payload[0], 1, e.length, out);
+        }
+        offset += e.length;
+    }
+
+    // The index is read in place, keep it aligned
+    static const uint8_t padding[sizeof(uint64_t)] = {};
+    size_t pad = (sizeof(uint64_t) - offset % sizeof(uint64_t)) % sizeof(uint64_t);
+    fwrite(padding, 1, pad, out);
+    header.indexOffset = offset + pad;
+    fwrite(&index[0], sizeof(AnimationPackEntry), index.size(), out);
+
+    fseek(out, 0, SEEK_SET);
+    fwrite(&header, sizeof(header), 1, out);
+    if (fclose(out) != 0)
+    {
+        fprintf(stderr, "Couldn't write '%s'\n", argv[2]);
+        return 1;
+    }
+
+    fprintf(stderr, "%u frames of %ux%u\n", header.frameCount, width, height);
+    return 0;
+}
@@ -0,0 +1,150 @@
+#include "Particles.h"
+#include "Tables.h"
+
+#include <stdlib.h>
+#include <time.h>
+
+using namespace rgb_matrix;
+
+template <typename T> static T * alignedArray(int count)
+{
+    void *memory = NULL;
+    if (posix_memalign(&memory, PARTICLE_ALIGN, sizeof(T) * count) != 0)
+    {
+        abort();
+    }
+    return (T *)memory;
+}
+
+ParticleSystem::ParticleSystem(int width, int height, int capacity)
+{
+    this->width = width;
+    this->height = height;
+    this->capacity = capacity;
+    count = 0;
+    isDrawn = false;
+    randomState = (uint32_t)time(0) | 1;
+
+    x = alignedArray<float>(capacity);
+    y = alignedArray<float>(capacity);
+    vx = alignedArray<float>(capacity);
+    vy = alignedArray<float>(capacity);
+    life = alignedArray<float>(capacity);
+    color = alignedArray<Pixel>(capacity);
+}
+
+ParticleSystem::~ParticleSystem()
+{
+    free(x);
+    free(y);
+    free(vx);
+    free(vy);
+    free(life);
+    free(color);
+}
+
+// xorshift32
+uint32_t ParticleSystem::random()
+{
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return randomState;
+}
+
+// Particles flying out of a point in every direction, at up to the speed
+// in pixels per frame. Colors vary a little around the given one.
+void ParticleSystem::Burst(float x, float y, int count, float speed, Pixel color, int lifeFrames)
+{
+    int end = this->count + count < capacity ? this->count + count : capacity;
+    for (int i = this->count; i < end; i++)
+    {
+        uint32_t r = random();
+        int angle = r & TRIG_MASK;
+        float v = speed * ((r >> TRIG_BITS) & 0xFF) / 255.0f;
+        int dim = (r >> 24) & 0x3F;
+
+        this->x[i] = x;
+        this->y[i] = y;
+        vx[i] = v * FixedCos(angle) / TRIG_ONE;
+        vy[i] = v * FixedSin(angle) / TRIG_ONE;
+        life[i] = lifeFrames - (int)(r >> 28);
+        this->color[i] = MakePixel(color.r - (color.r * dim >> 8), color.g - (color.g * dim >> 8), color.b - (color.b * dim >> 8));
+    }
+    this->count = end;
+}
+
+void ParticleSystem::Clear()
+{
+    count = 0;
+}
+
+// Move every particle a frame, then drop the ones that burnt out or left
+// the sides or bottom of the frame
+void ParticleSystem::Update()
+{
+    float *__restrict px = x;
+    float *__restrict py = y;
+    float *__restrict pvx = vx;
+    float *__restrict pvy = vy;
+    float *__restrict plife = life;
+    for (int i = 0; i < count; i++)
+    {
+        pvx[i] *= PARTICLE_DRAG;
+        pvy[i] = pvy[i] * PARTICLE_DRAG + PARTICLE_GRAVITY;
+        px[i] += pvx[i];
+        py[i] += pvy[i];
+        plife[i] -= 1;
+    }
+
+    int kept = 0;
+    for (int i = 0; i < count; i++)
+    {
+        bool isAlive = plife[i] > 0 && px[i] >= 0 && px[i] < width && py[i] < height;
+        px[kept] = px[i];
+        py[kept] = py[i];
+        pvx[kept] = pvx[i];
+        pvy[kept] = pvy[i];
+        plife[kept] = plife[i];
+        color[kept] = color[i];
+        kept += isAlive;
+    }
+    count = kept;
+}
+
+// Whatever else drew on the frame is cleared on the next draw
+void ParticleSystem::InvalidateCanvas()
+{
+    isDrawn = true;
+}
+
+void ParticleSystem::Draw(FrameBuffer *frame)
+{
+    // Nothing to show and nothing shown, the frame stays as it is
+    if (count == 0 && !isDrawn)
+    {
+        return;
+    }
+
+    frame->Fill(MakePixel(0, 0, 0, 0));
+    for (int i = 0; i < count; i++)
+    {
+        int px = (int)x[i];
+        int py = (int)y[i];
+        if (py < 0)
+        {
+            continue;
+        }
+
+        int fade = life[i] < PARTICLE_FADE_FRAMES ? (int)(life[i] * 256 / PARTICLE_FADE_FRAMES) : 256;
+        Pixel &p = frame->Row(py)[px];
+        int r = p.r + (color[i].r * fade >> 8);
+        int g = p.g + (color[i].g * fade >> 8);
+        int b = p.b + (color[i].b * fade >> 8);
+        p.r = r > 255 ? 255 : r;
+        p.g = g > 255 ? 255 : g;
+        p.b = b > 255 ? 255 : b;
+    }
+    isDrawn = count > 0;
+    frame->MarkDirty();
+}
@@ -0,0 +1,58 @@
+#ifndef _particles
+#define _particles
+
+#include "FrameBuffer.h"
+
+#include <stdint.h>
+
+// Particles alive at once, bursts past it are cut short
+#define PARTICLE_CAPACITY 32768
+// Arrays are aligned for the widest vector unit
+#define PARTICLE_ALIGN 32
+// Pixels per frame squared, and the speed kept each frame
+#define PARTICLE_GRAVITY 0.03f
+#define PARTICLE_DRAG 0.985f
+// Frames a particle takes to fade out at the end of its life
+#define PARTICLE_FADE_FRAMES 24
+
+using namespace rgb_matrix;
+
+// Fixed pool of point particles for sparks and confetti.
+// Every property is its own aligned array, so moving them all is a few
+// straight loops over floats the compiler vectorizes. Dead particles are
+// culled by moving the live ones down, branch free, so the pool stays
+// packed. Nothing is allocated after construction.
+// Particles are splatted additively into a black frame, meant for a layer
+// the compositor adds so they glow over the layers below.
+class ParticleSystem
+{
+    private:
+        int width;
+        int height;
+        int capacity;
+        int count;
+        bool isDrawn;
+
+        float *x;
+        float *y;
+        float *vx;
+        float *vy;
+        float *life;
+        Pixel *color;
+        uint32_t randomState;
+
+        uint32_t random();
+    public:
+        ParticleSystem(int width, int height, int capacity);
+        ~ParticleSystem();
+
+        inline int Count() const { return count; }
+        void Burst(float x, float y, int count, float speed, Pixel color, int lifeFrames);
+        void Clear();
+        void Update();
+
+        void InvalidateCanvas();
+        void Draw(FrameBuffer *frame);
+};
+
+#endif
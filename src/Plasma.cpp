@@ -0,0 +1,207 @@
+#include "Plasma.h"
+#include "Tables.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+using namespace rgb_matrix;
+
+// Palette stops, the palette blends between neighbouring ones
+#define PALETTE_STOPS 5
+
+// Radians per millisecond or frame as angle steps per frame, with
+// PLASMA_PHASE_BITS fraction bits
+#define PHASE_PER_MS(radians) ((int)((radians) * PLASMA_FRAME_MS * TRIG_STEPS / (2 * M_PI) * (1 << PLASMA_PHASE_BITS)))
+#define PHASE_PER_FRAME(radians) ((int)((radians) * TRIG_STEPS / (2 * M_PI) * (1 << PLASMA_PHASE_BITS)))
+#define ANGLE(radians) ((int)((radians) * TRIG_STEPS / (2 * M_PI)))
+
+Plasma::Plasma(TileRenderer *tiles, int width, int height)
+{
+    this->tiles = tiles;
+    this->width = width;
+    this->height = height;
+    mapWidth = 2 * width;
+    mapHeight = 2 * height;
+    if (plasmaMaps.width == mapWidth && plasmaMaps.height == mapHeight)
+    {
+        heightMap1 = plasmaMaps.heights1;
+        heightMap2 = plasmaMaps.heights2;
+    }
+    else
+    {
+        buildHeightMaps();
+    }
+
+    count = 0;
+    quality = QUALITY_LEVELS - 1;
+    sums.resize(tiles->TileCount(width, height), std::vector<uint8_t>(width));
+
+    makeRandomPalette(palette1);
+    makeRandomPalette(palette2);
+    blendPalette(0);
+    paletteDirection = true;
+    move();
+
+    // Prevent a button getting immediately handled
+    for (int i = 0; i < TOTAL_INPUTS; i++)
+    {
+        prevInputs[i] = true;
+    }
+}
+
+// Same maps as the baked ones, for a panel size the build wasn't made for
+void Plasma::buildHeightMaps()
+{
+    builtMap1.resize(mapWidth * mapHeight);
+    builtMap2.resize(mapWidth * mapHeight);
+    for (int y = 0; y < mapHeight; y++)
+    {
+        for (int x = 0; x < mapWidth; x++)
+        {
+            int i = y * mapWidth + x;
+            PlasmaHeights(mapWidth, mapHeight, x, y, &builtMap1[i], &builtMap2[i]);
+        }
+    }
+    heightMap1 = &builtMap1[0];
+    heightMap2 = &builtMap2[0];
+}
+
+// Gradient through random colors
+void Plasma::makeRandomPalette(Pixel *palette)
+{
+    Pixel stops[PALETTE_STOPS];
+    for (int i = 0; i < PALETTE_STOPS; i++)
+    {
+        stops[i] = MakePixel(rand() % 256, rand() % 256, rand() % 256);
+    }
+
+    int span = PLASMA_PALETTE_SIZE / (PALETTE_STOPS - 1);
+    for (int i = 0; i < PLASMA_PALETTE_SIZE; i++)
+    {
+        const Pixel &a = stops[i / span];
+        const Pixel &b = stops[i / span + 1];
+        int f = (i % span) * 256 / span;
+        palette[i] = MakePixel(a.r + (((b.r - a.r) * f) >> 8),
+                               a.g + (((b.g - a.g) * f) >> 8),
+                               a.b + (((b.b - a.b) * f) >> 8));
+    }
+}
+
+// Blend the two palettes, weight 0 is the first and 256 the second
+void Plasma::blendPalette(int weight)
+{
+    const uint8_t *a = (const uint8_t *)palette1;
+    const uint8_t *b = (const uint8_t *)palette2;
+    uint8_t *out = (uint8_t *)palette;
+    int inverse = 256 - weight;
+    for (int i = 0; i < (int)sizeof(palette); i++)
+    {
+        out[i] = (a[i] * inverse + b[i] * weight) >> 8;
+    }
+}
+
+// Map offset along a slow cosine of the frame count, within [0, size]
+int Plasma::offset(int speed, int phase, int size) const
+{
+    int angle = (int)(((int64_t)count * speed) >> PLASMA_PHASE_BITS) + phase;
+    return ((FixedCos(angle) + TRIG_ONE) * size) >> (TRIG_SHIFT + 1);
+}
+
+// Slide the maps, offsets stay within the part of the map past the frame
+void Plasma::move()
+{
+    dx1 = offset(PHASE_PER_MS(0.0002), ANGLE(0.4 + M_PI), width);
+    dy1 = offset(PHASE_PER_MS(0.0003), ANGLE(-0.1), height);
+    dx2 = offset(PHASE_PER_MS(-0.0002), ANGLE(1.2), width);
+    dy2 = offset(PHASE_PER_MS(-0.0003), ANGLE(-0.8 + M_PI), height);
+}
+
+// Both map rows are summed in one pass the compiler turns into vector byte
+// adds, then every sum is looked up in the palette
+void Plasma::renderRow(Pixel *row, int y, uint8_t *sum, int step)
+{
+    const uint8_t *h1 = &heightMap1[(y + dy1) * mapWidth + dx1];
+    const uint8_t *h2 = &heightMap2[(y + dy2) * mapWidth + dx2];
+    for (int x = 0; x < width; x++)
+    {
+        sum[x] = h1[x] + h2[x];
+    }
+
+    if (step == 1)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            row[x] = palette[sum[x]];
+        }
+        return;
+    }
+
+    for (int x = 0; x < width; x += step)
+    {
+        row[x] = palette[sum[x]];
+        if (x + 1 < width)
+        {
+            row[x + 1] = row[x];
+        }
+    }
+}
+
+int Plasma::Loop(FrameBuffer *frame, volatile bool *inputs)
+{
+    // Proccess inputs on button down
+    if (inputs[MenuButton] && !prevInputs[MenuButton])
+    {
+        for (int i = 0; i < TOTAL_INPUTS; i++)
+        {
+            prevInputs[i] = inputs[i];
+            inputs[i] = false;
+        }
+
+        return -1;
+    }
+
+    for (int i = 0; i < TOTAL_INPUTS; i++)
+    {
+        prevInputs[i] = inputs[i];
+        inputs[i] = false;
+    }
+
+    count++;
+    move();
+
+    // Pick a new palette to blend to each time the blend turns around
+    int x = (int)(((int64_t)count * PHASE_PER_FRAME(0.0005)) >> PLASMA_PHASE_BITS);
+    bool direction = FixedSin(x) <= 0;
+    if (paletteDirection != direction)
+    {
+        paletteDirection = direction;
+        makeRandomPalette(direction ? palette2 : palette1);
+    }
+
+    // Lower quality keeps the blended palette for a few frames
+    int paletteStride = 1 << (QUALITY_LEVELS - 1 - quality);
+    if (count % paletteStride == 0)
+    {
+        blendPalette((FixedCos(x) + TRIG_ONE) >> (TRIG_SHIFT - 7));
+    }
+
+    // Rows are independent, render them in bands. Lowest quality renders
+    // at half resolution and doubles the pixels.
+    int step = quality == 0 ? 2 : 1;
+    tiles->Run(width, height, [&](int top, int bottom, int tile) {
+        uint8_t *sum = &sums[tile][0];
+        for (int y = top; y < bottom; y++)
+        {
+            Pixel *row = frame->Row(y);
+            if (y % step != 0 && y > top)
+            {
+                memcpy(row, frame->Row(y - 1), sizeof(Pixel) * width);
+                continue;
+            }
+            renderRow(row, y, sum, step);
+        }
+    });
+    frame->MarkDirty();
+
+    return 0;
+}
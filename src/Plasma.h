@@ -0,0 +1,66 @@
+#ifndef _plasma
+#define _plasma
+
+#include "Inputs.h"
+#include "FrameBuffer.h"
+#include "FrameBudget.h"
+#include "TileRenderer.h"
+
+#include <stdint.h>
+#include <vector>
+
+// Milliseconds a frame moves the height maps along, about one frame period
+#define PLASMA_FRAME_MS 16
+// Angle steps per frame are kept with this many fraction bits
+#define PLASMA_PHASE_BITS 10
+#define PLASMA_PALETTE_SIZE 256
+
+using namespace rgb_matrix;
+
+// Two height maps slid over each other, their summed height picks a color
+// from a palette that slowly blends between two random ones.
+// The maps are twice the frame in both directions and stored as bytes,
+// their heights sum to at most 255, so a row is one byte add per pixel and
+// a palette lookup. Palettes blend in 8.8 fixed point.
+// Maps of the panel size the build was made for come baked from Tables.h,
+// and movement runs on the fixed point trig tables, no libm per frame.
+class Plasma
+{
+    private:
+        TileRenderer *tiles;
+        int width;
+        int height;
+        int mapWidth;
+        int mapHeight;
+        const uint8_t *heightMap1;
+        const uint8_t *heightMap2;
+        // Maps built at startup for other sizes
+        std::vector<uint8_t> builtMap1;
+        std::vector<uint8_t> builtMap2;
+        int dx1, dy1, dx2, dy2;
+
+        Pixel palette[PLASMA_PALETTE_SIZE];
+        Pixel palette1[PLASMA_PALETTE_SIZE];
+        Pixel palette2[PLASMA_PALETTE_SIZE];
+        bool paletteDirection;
+
+        unsigned count;
+        int quality;
+        // Summed heights of a row, one per band
+        std::vector<std::vector<uint8_t> > sums;
+        bool prevInputs[TOTAL_INPUTS];
+
+        void buildHeightMaps();
+        int offset(int speed, int phase, int size) const;
+        static void makeRandomPalette(Pixel *palette);
+        void blendPalette(int weight);
+        void move();
+        void renderRow(Pixel *row, int y, uint8_t *sum, int step);
+    public:
+        Plasma(TileRenderer *tiles, int width, int height);
+
+        inline void SetQuality(int level) { quality = level; }
+        int Loop(FrameBuffer *frame, volatile bool *inputs);
+};
+
+#endif
@@ -0,0 +1,71 @@
+#include "PowerGovernor.h"
+
+#include <stddef.h>
+
+using namespace rgb_matrix;
+
+PowerGovernor::PowerGovernor(ColorStage *color, int width, int height, int idleAfterSeconds, int idleBrightness, int busyPercent)
+{
+    this->color = color;
+    this->idleAfterSeconds = idleAfterSeconds;
+    this->idleBrightness = idleBrightness;
+    this->busyPercent = busyPercent;
+    activeBrightness = color->Brightness();
+    lastBusy = time(0);
+    isIdle = false;
+    previous = new FrameBuffer(width, height);
+}
+
+PowerGovernor::~PowerGovernor()
+{
+    delete previous;
+}
+
+// Count the pixels that changed since the last frame, a big enough change
+// counts as activity
+void PowerGovernor::NoteFrame(const FrameBuffer *frame)
+{
+    const Pixel *p = frame->Data();
+    Pixel *q = previous->Data();
+    int count = previous->width() * previous->height();
+    int changed = 0;
+    for (int i = 0; i < count; i++)
+    {
+        changed += p[i].r != q[i].r || p[i].g != q[i].g || p[i].b != q[i].b;
+        q[i] = p[i];
+    }
+
+    if (changed * 100 > count * busyPercent)
+    {
+        lastBusy = time(0);
+    }
+}
+
+// Returns true when the governor switched between active and idle, the
+// frame has to be presented again with the new brightness
+bool PowerGovernor::Update(bool isBusy)
+{
+    time_t now = time(0);
+    if (isBusy)
+    {
+        lastBusy = now;
+    }
+
+    bool shouldIdle = now - lastBusy >= idleAfterSeconds;
+    if (shouldIdle == isIdle)
+    {
+        return false;
+    }
+
+    isIdle = shouldIdle;
+    if (isIdle)
+    {
+        activeBrightness = color->Brightness();
+        color->SetBrightness(idleBrightness);
+    }
+    else
+    {
+        color->SetBrightness(activeBrightness);
+    }
+    return true;
+}
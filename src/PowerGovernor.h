@@ -0,0 +1,37 @@
+#ifndef _powergovernor
+#define _powergovernor
+
+#include "ColorStage.h"
+#include "FrameBuffer.h"
+
+#include <ctime>
+
+using namespace rgb_matrix;
+
+// Dims the display and lets the main loop slow down once it has been
+// static for a while. Input, or a frame that changes more than a small
+// part of the display, wakes it back up.
+class PowerGovernor
+{
+    private:
+        ColorStage *color;
+        int activeBrightness;
+        int idleBrightness;
+        int idleAfterSeconds;
+        int busyPercent;
+
+        time_t lastBusy;
+        bool isIdle;
+
+        // Last frame seen, to measure how much of the next one changed
+        FrameBuffer *previous;
+    public:
+        PowerGovernor(ColorStage *color, int width, int height, int idleAfterSeconds, int idleBrightness, int busyPercent);
+        ~PowerGovernor();
+
+        void NoteFrame(const FrameBuffer *frame);
+        bool Update(bool isBusy);
+        inline bool IsIdle() const { return isIdle; }
+};
+
+#endif
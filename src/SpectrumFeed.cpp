@@ -0,0 +1,74 @@
+#include "SpectrumFeed.h"
+
+#include <math.h>
+
+SpectrumFeed::SpectrumFeed(Waterfall *waterfall, volatile bool &isStopped)
+    : isStopped(isStopped)
+{
+    this->waterfall = waterfall;
+    fft = NULL;
+    minK = 0;
+    maxK = 0;
+
+    // Without a capture device nothing is started
+    sync = std::make_shared<ThreadSync>();
+    audio = new AlsaInput(isStopped, sync);
+    if (!audio->is_open())
+    {
+        return;
+    }
+
+    // Bin k of the transform is k * rate / size Hz
+    unsigned rate = audio->get_rate();
+    minK = (int)ceilf((float)SPECTRUM_MIN_HZ * SPECTRUM_FFT_SIZE / rate);
+    maxK = SPECTRUM_MAX_HZ * SPECTRUM_FFT_SIZE / rate;
+    minK = minK < 1 ? 1 : minK;
+    maxK = maxK > SPECTRUM_FFT_SIZE / 2 ? SPECTRUM_FFT_SIZE / 2 : maxK;
+    amp.resize(maxK);
+
+    fft = new FftData(SPECTRUM_FFT_SIZE, audio->get_data());
+    audio->start_thread();
+    thread = std::thread([this] { analyze(); });
+}
+
+// The flag has to be set first, the threads are only joined here
+SpectrumFeed::~SpectrumFeed()
+{
+    if (fft != NULL)
+    {
+        audio->join_thread();
+        thread.join();
+    }
+    delete fft;
+    delete audio;
+}
+
+void SpectrumFeed::analyze()
+{
+    std::shared_ptr<CircularBuffer<Sample>> samples = audio->get_data();
+    int64_t last = 0;
+    while (!isStopped)
+    {
+        // The ring is only read while the capture thread can't write it
+        Sample *out = NULL;
+        sync->consume([&] { return isStopped || samples->get_latest() - last >= SPECTRUM_HOP; },
+            [&] {
+                if (!isStopped)
+                {
+                    last = samples->get_latest();
+                    out = fft->execute();
+                }
+            },
+            [] {});
+        if (out == NULL)
+        {
+            break;
+        }
+
+        for (int k = minK; k < maxK; k++)
+        {
+            amp[k] = std::abs(out[k]);
+        }
+        waterfall->PushSpectrum(&amp[0], minK, maxK);
+    }
+}
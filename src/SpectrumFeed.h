@@ -0,0 +1,47 @@
+#ifndef _spectrumfeed
+#define _spectrumfeed
+
+#include "Waterfall.h"
+#include "Audio/AlsaInput.h"
+#include "Audio/FFTData.h"
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Samples transformed at once, and new samples between two transforms
+#define SPECTRUM_FFT_SIZE 2048
+#define SPECTRUM_HOP 1024
+// Frequencies the waterfall shows
+#define SPECTRUM_MIN_HZ 60
+#define SPECTRUM_MAX_HZ 8000
+
+// Feeds the waterfall from the sound card.
+// The capture thread writes samples into the input's ring, the analysis
+// thread wakes once a hop of new ones has arrived, transforms the newest
+// window and pushes its magnitudes to the waterfall. Both stop when the
+// flag they were given is set.
+class SpectrumFeed
+{
+    private:
+        Waterfall *waterfall;
+        volatile bool &isStopped;
+        std::shared_ptr<ThreadSync> sync;
+        AlsaInput *audio;
+        FftData *fft;
+        std::thread thread;
+
+        // Bins shown, and the magnitudes of the last transform
+        int minK;
+        int maxK;
+        std::vector<float> amp;
+
+        void analyze();
+    public:
+        SpectrumFeed(Waterfall *waterfall, volatile bool &isStopped);
+        ~SpectrumFeed();
+
+        inline bool IsOpen() const { return fft != NULL; }
+};
+
+#endif
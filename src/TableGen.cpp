@@ -0,0 +1,61 @@
+// Build time tool baking the lookup tables effects use instead of libm.
+// Usage: TableGen <panel width> <panel height> > Tables.h
+
+#include "LookupTables.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <vector>
+
+static void printBytes(const char *name, const std::vector<uint8_t> &values)
+{
+    printf("constexpr uint8_t %s[%d] =\n{", name, (int)values.size());
+    for (size_t i = 0; i < values.size(); i++)
+    {
+        printf("%s%3d,", i % 16 == 0 ? "\n    " : " ", values[i]);
+    }
+    printf("\n};\n\n");
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 3 || atoi(argv[1]) <= 0 || atoi(argv[2]) <= 0)
+    {
+        fprintf(stderr, "Usage: %s <panel width> <panel height>\n", argv[0]);
+        return 1;
+    }
+    int mapWidth = 2 * atoi(argv[1]);
+    int mapHeight = 2 * atoi(argv[2]);
+
+    printf("// Generated by TableGen, do not edit\n\n");
+    printf("#ifndef _tables\n#define _tables\n\n#include \"LookupTables.h\"\n\n");
+
+    printf("constexpr int16_t sineTable[TRIG_STEPS] =\n{");
+    for (int i = 0; i < TRIG_STEPS; i++)
+    {
+        printf("%s%6ld,", i % 8 == 0 ? "\n    " : " ", lround(sin(2 * M_PI * i / TRIG_STEPS) * TRIG_ONE));
+    }
+    printf("\n};\n\n");
+
+    std::vector<uint8_t> heights1(mapWidth * mapHeight);
+    std::vector<uint8_t> heights2(mapWidth * mapHeight);
+    for (int y = 0; y < mapHeight; y++)
+    {
+        for (int x = 0; x < mapWidth; x++)
+        {
+            PlasmaHeights(mapWidth, mapHeight, x, y, &heights1[y * mapWidth + x], &heights2[y * mapWidth + x]);
+        }
+    }
+    printf("// Plasma height maps for a %sx%s panel\n", argv[1], argv[2]);
+    printBytes("plasmaHeights1", heights1);
+    printBytes("plasmaHeights2", heights2);
+    printf("constexpr PlasmaMaps plasmaMaps = { %d, %d, plasmaHeights1, plasmaHeights2 };\n\n", mapWidth, mapHeight);
+
+    printf("inline int FixedSin(int angle) { return sineTable[angle & TRIG_MASK]; }\n");
+    printf("inline int FixedCos(int angle) { return sineTable[(angle + TRIG_STEPS / 4) & TRIG_MASK]; }\n\n");
+
+    printf("#endif\n");
+    return 0;
+}
@@ -0,0 +1,143 @@
+#include "TerminalPreview.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <unistd.h>
+
+using namespace rgb_matrix;
+
+// Upper half block in UTF-8
+#define HALF_BLOCK "\xE2\x96\x80"
+// Longest escape sequence written, a cursor move to two 11 character ints
+#define ESCAPE_MAX 32
+
+static inline bool samePixel(const Pixel &a, const Pixel &b)
+{
+    return a.r == b.r && a.g == b.g && a.b == b.b;
+}
+
+TerminalPreview::TerminalPreview(int fd, int width, int height)
+{
+    this->fd = fd;
+    shown = new FrameBuffer(width, height);
+    output.reserve(width * (height + 1) / 2 * 48);
+    InvalidateCanvas();
+}
+
+TerminalPreview::~TerminalPreview()
+{
+    // Leave the cursor below the frame with the terminal's own colors
+    moveTo(0, (shown->height() + 1) / 2);
+    output += "\x1b[0m\x1b[?25h";
+    flush();
+    delete shown;
+}
+
+// The terminal may have been drawn over, next frame is written in full
+void TerminalPreview::InvalidateCanvas()
+{
+    isDrawn = false;
+}
+
+void TerminalPreview::moveTo(int column, int row)
+{
+    if (column == cursorX && row == cursorY)
+    {
+        return;
+    }
+    char buffer[ESCAPE_MAX];
+    snprintf(buffer, sizeof(buffer), "\x1b[%d;%dH", row + 1, column + 1);
+    output += buffer;
+    cursorX = column;
+    cursorY = row;
+}
+
+void TerminalPreview::setColors(const Pixel &top, const Pixel &bottom)
+{
+    char buffer[ESCAPE_MAX];
+    if (!samePixel(top, foreground))
+    {
+        snprintf(buffer, sizeof(buffer), "\x1b[38;2;%d;%d;%dm", top.r, top.g, top.b);
+        output += buffer;
+        foreground = top;
+    }
+    if (!samePixel(bottom, background))
+    {
+        snprintf(buffer, sizeof(buffer), "\x1b[48;2;%d;%d;%dm", bottom.r, bottom.g, bottom.b);
+        output += buffer;
+        background = bottom;
+    }
+}
+
+void TerminalPreview::flush()
+{
+    const char *data = output.data();
+    size_t left = output.size();
+    while (left > 0)
+    {
+        ssize_t written = write(fd, data, left);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            perror("write()");
+            break;
+        }
+        data += written;
+        left -= written;
+    }
+    output.clear();
+}
+
+void TerminalPreview::Present(const FrameBuffer *frame)
+{
+    int w = shown->width();
+    int h = shown->height();
+
+    if (!isDrawn)
+    {
+        // Clear, hide the cursor and forget what the terminal holds
+        output += "\x1b[0m\x1b[2J\x1b[?25l\x1b[H";
+        cursorX = 0;
+        cursorY = 0;
+        foreground = MakePixel(0, 0, 0);
+        background = MakePixel(0, 0, 0);
+        output += "\x1b[38;2;0;0;0m\x1b[48;2;0;0;0m";
+    }
+
+    const Pixel black = MakePixel(0, 0, 0);
+    for (int y = 0; y < h; y += 2)
+    {
+        const Pixel *top = frame->Row(y);
+        const Pixel *bottom = y + 1 < h ? frame->Row(y + 1) : NULL;
+        Pixel *shownTop = shown->Row(y);
+        Pixel *shownBottom = y + 1 < h ? shown->Row(y + 1) : NULL;
+        for (int x = 0; x < w; x++)
+        {
+            const Pixel &lower = bottom != NULL ? bottom[x] : black;
+            if (isDrawn && samePixel(top[x], shownTop[x]) && (bottom == NULL || samePixel(lower, shownBottom[x])))
+            {
+                continue;
+            }
+
+            moveTo(x, y / 2);
+            setColors(top[x], lower);
+            output += HALF_BLOCK;
+            cursorX++;
+
+            shownTop[x] = top[x];
+            if (bottom != NULL)
+            {
+                shownBottom[x] = lower;
+            }
+        }
+    }
+    isDrawn = true;
+
+    if (!output.empty())
+    {
+        flush();
+    }
+}
@@ -0,0 +1,41 @@
+#ifndef _terminalpreview
+#define _terminalpreview
+
+#include "FrameBuffer.h"
+
+#include <string>
+
+using namespace rgb_matrix;
+
+// Shows frames in a truecolor terminal instead of the panels.
+// Every character cell is an upper half block, its foreground the upper
+// pixel and its background the one below, so a 64x64 frame takes 64
+// columns by 32 rows. Only cells that changed since the last frame are
+// written, and colors and cursor moves only when they differ from what the
+// terminal already has, so an unchanged frame writes nothing.
+class TerminalPreview
+{
+    private:
+        int fd;
+        FrameBuffer *shown;
+        bool isDrawn;
+        std::string output;
+
+        // Terminal state after the last write
+        int cursorX;
+        int cursorY;
+        Pixel foreground;
+        Pixel background;
+
+        void moveTo(int column, int row);
+        void setColors(const Pixel &top, const Pixel &bottom);
+        void flush();
+    public:
+        TerminalPreview(int fd, int width, int height);
+        ~TerminalPreview();
+
+        void InvalidateCanvas();
+        void Present(const FrameBuffer *frame);
+};
+
+#endif
@@ -2,11 +2,14 @@
 
 #include <iostream>
 #include<thread>
+#include <string.h>
 
 using namespace rgb_matrix;
 using rgb_matrix::RGBMatrix;
 using rgb_matrix::Canvas;
 
+const uint32_t cellKeyInvalid = 0xFFFFFFFF;
+
 // ---------- Helpers ----------
 
 uint8_t Tetris::scale_col(int val, int lo, int hi) {
@@ -23,14 +26,33 @@ uint8_t Tetris::scale_col(int val, int lo, int hi) {
     return 255 * (val - lo) / (hi - lo);
 }
 
-Color * Tetris::getDefaultColor(int x, int y, Canvas *c)
+// Default color is a red ramp along x and a green to blue ramp along y,
+// both sliding with the shift. Precompute every shifted value once so
+// drawing is a lookup instead of a division per pixel.
+void Tetris::buildGradientCache(int width, int height)
 {
-    int shift = defaultColorShift % c->width();
-    return new Color(
-        scale_col(x + shift, 0, c->width()),
-        255 - scale_col(y - shift, 0, c->height()),
-        scale_col(y - shift, 0, c->height())
-    );
+    gradientWidth = width;
+    gradientHeight = height;
+
+    // x + shift covers [0, 2 * width)
+    gradientRed.resize(2 * width);
+    for (int i = 0; i < 2 * width; i++)
+    {
+        gradientRed[i] = scale_col(i, 0, width);
+    }
+
+    // y - shift covers [-width, height)
+    gradientBlue.resize(width + height);
+    for (int i = 0; i < width + height; i++)
+    {
+        gradientBlue[i] = scale_col(i - width, 0, height);
+    }
+}
+
+Pixel Tetris::getDefaultColor(int x, int y)
+{
+    uint8_t blue = gradientBlue[y - gradientShift + gradientWidth];
+    return MakePixel(gradientRed[x + gradientShift], 255 - blue, blue);
 }
 
 void Tetris::UpdateDefaultColorShift()
@@ -59,6 +81,109 @@ void Tetris::UpdateDefaultColorShift()
     }
 }
 
+// Render every way a block can look once, drawing is then copying rows
+void Tetris::buildTileAtlas()
+{
+    for (int bY = 0; bY < BLOCK_SIZE; bY++)
+    {
+        for (int bX = 0; bX < BLOCK_SIZE; bX++)
+        {
+            bool isBorder = bX == 0 || bY == 0 || bX == BLOCK_SIZE - 1 || bY == BLOCK_SIZE - 1;
+
+            tileAtlas[EmptyTile].pixels[bY][bX] = MakePixel(0, 0, 0);
+            tileAtlas[PieceTile].pixels[bY][bX] = isBorder ? MakePixel(255, 25, 25) : MakePixel(100, 100, 100);
+            // Default border is taken from the gradient while blitting
+            tileAtlas[DefaultTile].pixels[bY][bX] = isBorder ? MakePixel(255, 255, 255) : MakePixel(20, 20, 20);
+            tileAtlas[BlueTile].pixels[bY][bX] = isBorder ? MakePixel(38, 48, 195) : MakePixel(20, 20, 20);
+            tileAtlas[PinkTile].pixels[bY][bX] = isBorder ? MakePixel(210, 42, 171) : MakePixel(20, 20, 20);
+
+            // Clear line animation fades from white
+            for (int step = 0; step < CLEAR_FADE_STEPS; step++)
+            {
+                uint shift = step * 3;
+                if (shift > 255)
+                {
+                    shift = 0;
+                }
+                tileAtlas[ClearTile + step].pixels[bY][bX] = MakePixel(255 - shift, 255 - shift, 255 - shift);
+            }
+        }
+    }
+}
+
+// Tile a cell is drawn with
+int Tetris::getCellTile(int row, int col, bool isPiece)
+{
+    BlockStatus status = tetrisBoard[row].cols[col];
+    if (status == None)
+    {
+        return isPiece ? PieceTile : EmptyTile;
+    }
+    else if (tetrisBoard[row].toClear)
+    {
+        return ClearTile + (clearCount < CLEAR_FADE_STEPS ? clearCount : CLEAR_FADE_STEPS - 1);
+    }
+
+    switch (status)
+    {
+        case Blue:
+            return BlueTile;
+        case Pink:
+            return PinkTile;
+        case Default:
+        default:
+            return DefaultTile;
+    }
+}
+
+void Tetris::drawBorder(FrameBuffer *frame)
+{
+    for (int y = 0; y < frame->height(); y++)
+    {
+        for (int x = 0; x < frame->width(); x++)
+        {
+            if ((x < boardXOffset || x > boardXOffset - 1 + (BLOCK_SIZE * TETRIS_BOARD_COLS)) ||
+                (y > frame->height() - boardYOffset - 1 || y < frame->height() - boardYOffset - 1 - (BLOCK_SIZE * TETRIS_BOARD_ROWS)))
+            {
+                // Draw border background
+                frame->Set(x, y, 108, 64, 173);
+
+                // TODO Draw preview piece in border
+            }
+        }
+    }
+}
+
+void Tetris::drawCell(FrameBuffer *frame, int row, int col, int tile)
+{
+    int xOrig = boardXOffset + col * BLOCK_SIZE;
+    int yOrig = frame->height() - boardYOffset - 1 - row * BLOCK_SIZE;
+
+    for (int bY = 0; bY < BLOCK_SIZE; bY++)
+    {
+        int y = yOrig - bY;
+        Pixel *span = frame->Row(y) + xOrig;
+        memcpy(span, tileAtlas[tile].pixels[bY], sizeof(Pixel) * BLOCK_SIZE);
+
+        if (tile == DefaultTile)
+        {
+            // Draw gradient block border over the tile
+            if (bY == 0 || bY == BLOCK_SIZE - 1)
+            {
+                for (int bX = 0; bX < BLOCK_SIZE; bX++)
+                {
+                    span[bX] = getDefaultColor(xOrig + bX, y);
+                }
+            }
+            else
+            {
+                span[0] = getDefaultColor(xOrig, y);
+                span[BLOCK_SIZE - 1] = getDefaultColor(xOrig + BLOCK_SIZE - 1, y);
+            }
+        }
+    }
+}
+
 // Copy board line from src row to dest row
 void Tetris::copyLine(int src, int dest)
 {
@@ -69,6 +194,30 @@ void Tetris::copyLine(int src, int dest)
     tetrisBoard[dest].toClear = false;
 }
 
+// Sparks in the board gradient out of every cell of the marked lines
+void Tetris::burstClearedLines()
+{
+    // Nothing drawn yet, there is no board position to burst from
+    if (particles == NULL || gradientHeight == 0)
+    {
+        return;
+    }
+
+    for (int row = 0; row < TETRIS_BOARD_ROWS; row++)
+    {
+        if (!tetrisBoard[row].toClear)
+        {
+            continue;
+        }
+        int y = gradientHeight - boardYOffset - 1 - row * BLOCK_SIZE - BLOCK_SIZE / 2;
+        for (int col = 0; col < TETRIS_BOARD_COLS; col++)
+        {
+            int x = boardXOffset + col * BLOCK_SIZE + BLOCK_SIZE / 2;
+            particles->Burst(x, y, CLEAR_CELL_PARTICLES, CLEAR_PARTICLE_SPEED, getDefaultColor(x, y), CLEAR_PARTICLE_FRAMES);
+        }
+    }
+}
+
 // Clear lines that are marked
 void Tetris::clearLines ()
 {
@@ -185,10 +334,19 @@ void Tetris::InitTetris()
 
     tState = Normal;
     defaultColorShift = 0;
+    gradientShift = 0;
+    gradientStride = 1;
+    gradientWidth = 0;
+    gradientHeight = 0;
+    boardXOffset = 0;
+    boardYOffset = 0;
     gravityCount = 0;
     clearCount = 0;
+    buildTileAtlas();
     nextShape = 0;
 
+    InvalidateCanvas();
+
     srand(time(NULL));
     clearPieceBag();
     addPiece();
@@ -206,8 +364,22 @@ void Tetris::CleanupTetris()
     }
 }
 
+// Forget what was drawn, next draw repaints everything
+void Tetris::InvalidateCanvas()
+{
+    isBorderDrawn = false;
+    for (int row = 0; row < TETRIS_BOARD_ROWS; row++)
+    {
+        for (int col = 0; col < TETRIS_BOARD_COLS; col++)
+        {
+            cellKeys[row][col] = cellKeyInvalid;
+        }
+    }
+}
+
 Tetris::Tetris()
 {
+    particles = NULL;
     InitTetris();
 }
 
@@ -216,115 +388,85 @@ Tetris::~Tetris()
     CleanupTetris();
 }
 
+// Lower quality moves the block gradient in bigger, less frequent steps
+void Tetris::SetQuality(int level)
+{
+    gradientStride = 1 << (QUALITY_LEVELS - 1 - level);
+}
+
 // ---------- Game Functions ----------
 
-void Tetris::DrawTetris(RGBMatrix *matrix)
+// Board position for a frame size, centered and raised a little
+static void boardOffsets(int width, int height, int *xOffset, int *yOffset)
 {
-    FrameCanvas *canvas = matrix->CreateFrameCanvas();
+    *xOffset = (width - BLOCK_SIZE * TETRIS_BOARD_COLS) / 2;
+    *yOffset = (height - BLOCK_SIZE * TETRIS_BOARD_ROWS) / 2 + BOARD_Y_RAISE;
+}
+
+// Cells are blitted without clipping, the whole board has to be on the frame
+bool Tetris::FitsFrame(int width, int height)
+{
+    int xOffset, yOffset;
+    boardOffsets(width, height, &xOffset, &yOffset);
+    return xOffset >= 0 && width - xOffset >= BLOCK_SIZE * TETRIS_BOARD_COLS &&
+        yOffset >= 0 && height - yOffset >= BLOCK_SIZE * TETRIS_BOARD_ROWS;
+}
+
+void Tetris::DrawTetris(FrameBuffer *frame)
+{
+    if (!FitsFrame(frame->width(), frame->height()))
+    {
+        return;
+    }
+
+    if (gradientWidth != frame->width() || gradientHeight != frame->height())
+    {
+        buildGradientCache(frame->width(), frame->height());
+        boardOffsets(frame->width(), frame->height(), &boardXOffset, &boardYOffset);
+        InvalidateCanvas();
+    }
 
     UpdateDefaultColorShift();
+    gradientShift = (defaultColorShift - defaultColorShift % gradientStride) % gradientWidth;
+
+    // Border never changes, only draw it again if something drew over it
+    if (!isBorderDrawn)
+    {
+        drawBorder(frame);
+        isBorderDrawn = true;
+        frame->MarkDirty();
+    }
 
-    for (int x = 0; x < canvas->width(); x++)
+    // Don't draw piece if clearing
+    bool pieceCells[TETRIS_BOARD_ROWS][TETRIS_BOARD_COLS] = {};
+    if (tState != ClearAnimation)
     {
-        for (int y = 0; y < canvas->height(); y++)
+        for (int block = 0; block < PIECE_SIZE; block++)
         {
-            if ((x < BOARD_X_OFFSET || x > BOARD_X_OFFSET - 1 + (BLOCK_SIZE * TETRIS_BOARD_COLS)) ||
-                (y > canvas->height() - BOARD_Y_OFFSET - 1 || y < canvas->height() - BOARD_Y_OFFSET - 1 - (BLOCK_SIZE * TETRIS_BOARD_ROWS)))
+            if (currentPiece[block].y < TETRIS_BOARD_ROWS)
             {
-                // Draw border background
-                canvas->SetPixel(x, y, 108, 64, 173);
-
-                // TODO Draw preview piece in border
+                pieceCells[currentPiece[block].y][currentPiece[block].x] = true;
             }
-            else
-            {
-                // Draw tetris board
-                int col = (x - BOARD_X_OFFSET) / BLOCK_SIZE;
-                int row = (canvas->height() - y - BOARD_Y_OFFSET - 1) / BLOCK_SIZE;
+        }
+    }
 
-                if (tetrisBoard[row].cols[col] == None)
-                {
-                    // Draw board background or piece block
-                    canvas->SetPixel(x, y, 0, 0, 0);
-                    for (int block = 0; block < PIECE_SIZE; block++)
-                    {
-                        // Don't draw piece if clearing
-                        if (tState != ClearAnimation && currentPiece[block].x == col && currentPiece[block].y == row)
-                        {
-                            int bX = (x - BOARD_X_OFFSET) % BLOCK_SIZE;
-                            int bY = (canvas->height() -y - BOARD_Y_OFFSET - 1) % BLOCK_SIZE;
-                            if (bX == 0 || bY == 0 || bX == BLOCK_SIZE - 1 || bY == BLOCK_SIZE - 1)
-                            {
-                                // Draw piece block border
-                                canvas->SetPixel(x, y, 255, 25, 25);
-                            }
-                            else 
-                            {
-                                // Draw piece block
-                                canvas->SetPixel(x, y, 100, 100, 100);
-                            }
-                            break;
-                        }
-                    }
-                }
-                else if (tetrisBoard[row].toClear)
-                {
-                    // Draw clear line animation
-                    uint shift = clearCount * 3;
-                    if (shift > 255)
-                    {
-                        shift = 0;
-                    }
-                    canvas->SetPixel(x, y, 255 - shift, 255 - shift, 255 - shift);
-                }
-                else
-                {
-                    // Draw board block
-                    int bX = (x - BOARD_X_OFFSET) % BLOCK_SIZE;
-                    int bY = (canvas->height() -y - BOARD_Y_OFFSET - 1) % BLOCK_SIZE;
-                    
-                    if (bX == 0 || bY == 0 || bX == BLOCK_SIZE - 1 || bY == BLOCK_SIZE - 1)
-                    {
-                        // Draw block border
-                        Color *c = new Color(255, 255, 255);
-                        switch(tetrisBoard[row].cols[col])
-                        {
-                            case Default:
-                            {
-                                c = getDefaultColor(x, y, canvas);
-                                break;
-                            }
-                            case Blue:
-                            {
-                                c->r = 38;
-                                c->g = 48;
-                                c->b = 195;
-                                break;
-                            }
-                            case Pink:
-                            {
-                                c->r = 210;
-                                c->g = 42;
-                                c->b = 171;
-                                break;
-                            }
-                            default:
-                            case None:
-                            {
-                                break;
-                            }
-                        }
-                        canvas->SetPixel(x, y, c->r, c->g, c->b);
-                    }
-                    else
-                    {
-                        canvas->SetPixel(x, y, 20, 20, 20);
-                    }
-                }
+    // Only redraw cells that look different from what was last drawn
+    for (int row = 0; row < TETRIS_BOARD_ROWS; row++)
+    {
+        for (int col = 0; col < TETRIS_BOARD_COLS; col++)
+        {
+            int tile = getCellTile(row, col, pieceCells[row][col]);
+
+            // Default tiles also change with the gradient
+            uint32_t key = tile == DefaultTile ? tile | (gradientShift << 16) : tile;
+            if (cellKeys[row][col] != key)
+            {
+                drawCell(frame, row, col, tile);
+                cellKeys[row][col] = key;
+                frame->MarkDirty();
             }
         }
     }
-    matrix->SwapOnVSync(canvas, 2U);
 }
 
 int Tetris::PlayTetris(volatile bool *inputs)
@@ -524,6 +666,10 @@ int Tetris::PlayTetris(volatile bool *inputs)
         }
         case ClearAnimation:
         {
+            if (clearCount == 0)
+            {
+                burstClearedLines();
+            }
             if (clearCount++ >= LINE_CLEAR_TARGET)
             {
                 // Mark the end of the line clearing stage
@@ -2,10 +2,15 @@
 #define _tetris
 
 #include "Inputs.h"
+#include "FrameBuffer.h"
+#include "FrameBudget.h"
+#include "Particles.h"
 
 #include "led-matrix.h"
 #include "graphics.h"
 
+#include <vector>
+
 // Tetris width always 10 wide
 #define TETRIS_BOARD_COLS 10
 #define TETRIS_BOARD_ROWS 12
@@ -13,12 +18,19 @@
 // How many pixels per Tetris block
 #define BLOCK_SIZE 5
 #define PIECE_SIZE 4
-#define BOARD_X_OFFSET 7
-#define BOARD_Y_OFFSET 4
+// Board is centered, and sits this much higher so it is flush with the
+// top of a 64 row display
+#define BOARD_Y_RAISE 2
 
 #define INPUT_DELAY_TARGET 5
 #define LINE_CLEAR_TARGET 50
 #define GRAVITY_UPDATE_TARGET 60
+// One clear animation tile per count, including the count it ends on
+#define CLEAR_FADE_STEPS (LINE_CLEAR_TARGET + 2)
+// Sparks flying out of every cell of a cleared line
+#define CLEAR_CELL_PARTICLES 48
+#define CLEAR_PARTICLE_SPEED 1.2f
+#define CLEAR_PARTICLE_FRAMES 50
 
 using namespace rgb_matrix;
 
@@ -92,14 +104,56 @@ class Tetris
         int defaultColorShift;
         bool isShiftInc;
 
+        // Precomputed default block gradient
+        std::vector<uint8_t> gradientRed;
+        std::vector<uint8_t> gradientBlue;
+        int gradientWidth;
+        int gradientHeight;
+        int gradientShift;
+        // Shifts the drawn gradient moves by, more redraws fewer cells
+        int gradientStride;
+
+        // Board position for the frame size, from the left and the bottom
+        int boardXOffset;
+        int boardYOffset;
+
         int gravityCount;
         int clearCount;
+        ParticleSystem *particles;
+
+        // Pre-rendered blocks, one per way a cell can look
+        enum tileIndex
+        {
+            EmptyTile,
+            PieceTile,
+            DefaultTile,
+            BlueTile,
+            PinkTile,
+            ClearTile,
+            TileCount = ClearTile + CLEAR_FADE_STEPS
+        };
+        struct Tile
+        {
+            Pixel pixels[BLOCK_SIZE][BLOCK_SIZE];
+        };
+        Tile tileAtlas[TileCount];
+
+        // What was last drawn, so only changed cells are redrawn
+        bool isBorderDrawn;
+        uint32_t cellKeys[TETRIS_BOARD_ROWS][TETRIS_BOARD_COLS];
 
         uint8_t scale_col(int val, int lo, int hi);
-        Color * getDefaultColor(int x, int y, Canvas *c);
+        void buildGradientCache(int width, int height);
+        Pixel getDefaultColor(int x, int y);
+
+        void buildTileAtlas();
+        int getCellTile(int row, int col, bool isPiece);
+        void drawBorder(FrameBuffer *frame);
+        void drawCell(FrameBuffer *frame, int row, int col, int tile);
 
         void copyLine(int src, int dest);
         void clearLines ();
+        void burstClearedLines();
 
         bool checkPiecePos(PiecePos *piece);
         void checkCurrentPiecePos();
@@ -112,9 +166,13 @@ class Tetris
 
         void InitTetris();
         void CleanupTetris();
+        void InvalidateCanvas();
 
         void UpdateDefaultColorShift();
+        void SetQuality(int level);
+        inline void SetParticles(ParticleSystem *particles) { this->particles = particles; }
 
-        void DrawTetris(RGBMatrix *matrix);
+        static bool FitsFrame(int width, int height);
+        void DrawTetris(FrameBuffer *frame);
         int PlayTetris(volatile bool *inputs);
 };
\ No newline at end of file
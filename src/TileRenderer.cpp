@@ -0,0 +1,110 @@
+#include "TileRenderer.h"
+
+#include <stddef.h>
+
+TileRenderer::TileRenderer(int threadCount)
+{
+    job = NULL;
+    tileCount = 1;
+    rowCount = 0;
+    generation = 0;
+    pending = 0;
+    isStopping = false;
+
+    // Worker i renders band i + 1
+    for (int i = 1; i < threadCount; i++)
+    {
+        workers.push_back(std::thread(&TileRenderer::work, this, i));
+    }
+}
+
+TileRenderer::~TileRenderer()
+{
+    {
+        std::lock_guard<std::mutex> locker(mux);
+        isStopping = true;
+    }
+    start.notify_all();
+    for (size_t i = 0; i < workers.size(); i++)
+    {
+        workers[i].join();
+    }
+}
+
+// How many bands a frame of this size is split into
+int TileRenderer::TileCount(int width, int height) const
+{
+    int count = (int)workers.size() + 1;
+    if (width * height < TILE_MIN_PIXELS || height < count)
+    {
+        return 1;
+    }
+    return count;
+}
+
+void TileRenderer::band(int tile, int *top, int *bottom) const
+{
+    *top = rowCount * tile / tileCount;
+    *bottom = rowCount * (tile + 1) / tileCount;
+}
+
+void TileRenderer::work(int tile)
+{
+    unsigned seen = 0;
+    while (true)
+    {
+        const Job *current;
+        {
+            std::unique_lock<std::mutex> locker(mux);
+            start.wait(locker, [&] { return isStopping || generation != seen; });
+            if (isStopping)
+            {
+                return;
+            }
+            seen = generation;
+            if (tile >= tileCount)
+            {
+                continue;
+            }
+            current = job;
+        }
+
+        int top, bottom;
+        band(tile, &top, &bottom);
+        (*current)(top, bottom, tile);
+
+        std::lock_guard<std::mutex> locker(mux);
+        if (--pending == 0)
+        {
+            done.notify_one();
+        }
+    }
+}
+
+void TileRenderer::Run(int width, int height, const Job &job)
+{
+    int count = TileCount(width, height);
+    if (count == 1)
+    {
+        job(0, height, 0);
+        return;
+    }
+
+    std::lock_guard<std::mutex> running(runMux);
+    {
+        std::lock_guard<std::mutex> locker(mux);
+        this->job = &job;
+        tileCount = count;
+        rowCount = height;
+        pending = count - 1;
+        generation++;
+    }
+    start.notify_all();
+
+    int top, bottom;
+    band(0, &top, &bottom);
+    job(top, bottom, 0);
+
+    std::unique_lock<std::mutex> locker(mux);
+    done.wait(locker, [&] { return pending == 0; });
+}
@@ -0,0 +1,45 @@
+#ifndef _tilerenderer
+#define _tilerenderer
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Frames smaller than this are not worth waking the workers for
+#define TILE_MIN_PIXELS 8192
+
+// Splits a frame into bands of rows and renders them on worker threads.
+// The calling thread renders the first band itself and Run returns once
+// every band is done, so a job may read what an earlier Run wrote.
+// Threads running jobs at the same time take turns on the workers.
+class TileRenderer
+{
+    private:
+        typedef std::function<void(int top, int bottom, int tile)> Job;
+
+        std::vector<std::thread> workers;
+        std::mutex runMux;
+        std::mutex mux;
+        std::condition_variable start;
+        std::condition_variable done;
+
+        const Job *job;
+        int tileCount;
+        int rowCount;
+        unsigned generation;
+        int pending;
+        bool isStopping;
+
+        void work(int tile);
+        void band(int tile, int *top, int *bottom) const;
+    public:
+        TileRenderer(int threadCount);
+        ~TileRenderer();
+
+        int TileCount(int width, int height) const;
+        void Run(int width, int height, const Job &job);
+};
+
+#endif
@@ -0,0 +1,183 @@
+#include "Waterfall.h"
+
+#include <math.h>
+#include <string.h>
+
+using namespace rgb_matrix;
+
+// Palette stops from silent to loud, spaced evenly
+static const uint8_t paletteStops[][3] =
+{
+    {   0,   0,   0 },
+    {  40,   0,  90 },
+    { 170,  20,  90 },
+    { 250, 110,   0 },
+    { 255, 230,  80 },
+    { 255, 255, 255 }
+};
+#define PALETTE_STOP_COUNT (sizeof(paletteStops) / sizeof(paletteStops[0]))
+
+Waterfall::Waterfall(int width, int height)
+{
+    this->width = width;
+    this->height = height;
+    columnBins.resize(width + 1);
+    columnMinK = -1;
+    columnMaxK = -1;
+
+    pending.resize(width);
+    queue.resize(WATERFALL_QUEUE_ROWS * width);
+    drained.resize(WATERFALL_QUEUE_ROWS * width);
+    pushed = 0;
+    popped = 0;
+
+    newest = 0;
+    isDrawn = false;
+
+    int span = 255 / (PALETTE_STOP_COUNT - 1);
+    for (int i = 0; i < 256; i++)
+    {
+        int stop = i / span < (int)PALETTE_STOP_COUNT - 1 ? i / span : PALETTE_STOP_COUNT - 2;
+        int f = (i - stop * span) * 256 / span;
+        const uint8_t *a = paletteStops[stop];
+        const uint8_t *b = paletteStops[stop + 1];
+        palette[i] = MakePixel(a[0] + (((b[0] - a[0]) * f) >> 8),
+                               a[1] + (((b[1] - a[1]) * f) >> 8),
+                               a[2] + (((b[2] - a[2]) * f) >> 8));
+    }
+
+    // Prevent a button getting immediately handled
+    for (int i = 0; i < TOTAL_INPUTS; i++)
+    {
+        prevInputs[i] = true;
+    }
+}
+
+Waterfall::~Waterfall()
+{
+}
+
+// Columns spaced evenly in log frequency, every column gets at least one bin
+void Waterfall::buildColumns(int minK, int maxK)
+{
+    columnMinK = minK;
+    columnMaxK = maxK;
+    double ratio = log((double)maxK / minK);
+    for (int x = 0; x <= width; x++)
+    {
+        columnBins[x] = (int)floor(minK * exp(ratio * x / width));
+    }
+    for (int x = 1; x <= width; x++)
+    {
+        if (columnBins[x] <= columnBins[x - 1])
+        {
+            columnBins[x] = columnBins[x - 1] + 1;
+        }
+    }
+}
+
+// A column shows the loudest of its bins
+void Waterfall::PushSpectrum(const float *amp, int minK, int maxK)
+{
+    if (minK < 1 || maxK <= minK)
+    {
+        return;
+    }
+    if (minK != columnMinK || maxK != columnMaxK)
+    {
+        buildColumns(minK, maxK);
+    }
+
+    uint8_t *row = &pending[0];
+    float scale = 255 / (WATERFALL_CEIL_DB - WATERFALL_FLOOR_DB);
+    for (int x = 0; x < width; x++)
+    {
+        float loudest = 0;
+        int end = columnBins[x + 1] < maxK ? columnBins[x + 1] : maxK;
+        for (int k = columnBins[x]; k < end; k++)
+        {
+            loudest = amp[k] > loudest ? amp[k] : loudest;
+        }
+
+        float level = loudest > 0 ? (20 * log10f(loudest) - WATERFALL_FLOOR_DB) * scale : 0;
+        row[x] = level <= 0 ? 0 : (level >= 255 ? 255 : (uint8_t)level);
+    }
+
+    std::lock_guard<std::mutex> lock(queueLock);
+    if (pushed - popped == WATERFALL_QUEUE_ROWS)
+    {
+        popped++;
+    }
+    memcpy(&queue[(pushed % WATERFALL_QUEUE_ROWS) * width], row, width);
+    pushed++;
+}
+
+// Something else drew on the frame, the ring starts again silent. Hops
+// queued while it wasn't shown are dropped, so no old rows show up.
+void Waterfall::InvalidateCanvas()
+{
+    {
+        std::lock_guard<std::mutex> lock(queueLock);
+        popped = pushed;
+    }
+    isDrawn = false;
+}
+
+int Waterfall::Loop(FrameBuffer *frame, volatile bool *inputs)
+{
+    // Proccess inputs on button down
+    if (inputs[MenuButton] && !prevInputs[MenuButton])
+    {
+        for (int i = 0; i < TOTAL_INPUTS; i++)
+        {
+            prevInputs[i] = inputs[i];
+            inputs[i] = false;
+        }
+
+        return -1;
+    }
+
+    for (int i = 0; i < TOTAL_INPUTS; i++)
+    {
+        prevInputs[i] = inputs[i];
+        inputs[i] = false;
+    }
+
+    int count;
+    {
+        std::lock_guard<std::mutex> lock(queueLock);
+        count = pushed - popped;
+        for (int i = 0; i < count; i++)
+        {
+            memcpy(&drained[i * width], &queue[((popped + i) % WATERFALL_QUEUE_ROWS) * width], width);
+        }
+        popped = pushed;
+    }
+    if (count == 0 && isDrawn)
+    {
+        return 0;
+    }
+
+    // The frame is the ring, it starts out silent
+    if (!isDrawn)
+    {
+        frame->Fill(MakePixel(0, 0, 0));
+        newest = 0;
+        isDrawn = true;
+    }
+
+    // One row of colors per hop, written over the oldest row
+    for (int i = 0; i < count; i++)
+    {
+        const uint8_t *levels = &drained[i * width];
+        newest = (newest + height - 1) % height;
+        Pixel *row = frame->Row(newest);
+        for (int x = 0; x < width; x++)
+        {
+            row[x] = palette[levels[x]];
+        }
+    }
+    frame->MarkDirty();
+
+    return 0;
+}
@@ -0,0 +1,68 @@
+#ifndef _waterfall
+#define _waterfall
+
+#include "Inputs.h"
+#include "FrameBuffer.h"
+
+#include <mutex>
+#include <stdint.h>
+#include <vector>
+
+// Analysis hops waiting to be drawn, when it is full a new hop replaces
+// the oldest so the newest rows are always the ones drawn
+#define WATERFALL_QUEUE_ROWS 8
+// Magnitudes shown, in dB of the FFT output
+#define WATERFALL_FLOOR_DB 0.0f
+#define WATERFALL_CEIL_DB 60.0f
+
+using namespace rgb_matrix;
+
+// Spectrogram scrolling down from the top, newest row first.
+// The audio thread pushes one spectrum per analysis hop, reduced to a row
+// of log magnitude levels with log spaced frequency columns, into a small
+// queue. The lock is only held to copy rows in and out. Every pass turns
+// the waiting rows into colors and writes them over the oldest rows of the
+// frame, which is kept as a ring. Nothing is moved, the compositor reads
+// the frame starting at NewestRow, so a hop costs one row of work.
+class Waterfall
+{
+    private:
+        int width;
+        int height;
+
+        // Producer side, first FFT bin of every column for the bin range
+        // they were made for, and the row being made
+        std::vector<int> columnBins;
+        int columnMinK;
+        int columnMaxK;
+        std::vector<uint8_t> pending;
+
+        std::mutex queueLock;
+        std::vector<uint8_t> queue;
+        unsigned pushed;
+        unsigned popped;
+
+        // Consumer side, rows taken out of the queue
+        std::vector<uint8_t> drained;
+
+        // Newest row of the ring, rows get older going down and wrap around
+        int newest;
+        bool isDrawn;
+        Pixel palette[256];
+        bool prevInputs[TOTAL_INPUTS];
+
+        void buildColumns(int minK, int maxK);
+    public:
+        Waterfall(int width, int height);
+        ~Waterfall();
+
+        // Audio thread, amplitudes of the FFT bins [minK, maxK)
+        void PushSpectrum(const float *amp, int minK, int maxK);
+
+        inline int NewestRow() const { return newest; }
+
+        void InvalidateCanvas();
+        int Loop(FrameBuffer *frame, volatile bool *inputs);
+};
+
+#endif